@@ -0,0 +1,172 @@
+#ifndef LE_ADMISSION_H
+#define LE_ADMISSION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+//Admission control in front of the lock.
+//At most K threads may actively contend for the lock at the same time; the rest park on a condition variable
+//until a contender gets the lock and leaves. This keeps oversubscribed runs (many more threads than cores,
+//specially with busy waiting) from spending the CPU on spinning instead of on useful work.
+//It is enabled with the LE_MAX_ACTIVE environment variable:
+//  LE_MAX_ACTIVE=<K>        fixed limit
+//  LE_MAX_ACTIVE=auto       K = number of online processors
+//  LE_MAX_ACTIVE=adaptive   starts at the number of online processors and tunes K from measured throughput
+//Every reader and writer queues for the lock by first calling le_admission_enter, and calls le_admission_exit
+//as soon as it holds the lock, so time spent waiting for admission counts as time waiting for the lock.
+
+#define LE_ADMISSION_OFF 0
+#define LE_ADMISSION_FIXED 1
+#define LE_ADMISSION_ADAPTIVE 2
+
+//Length of the throughput measurement window of the adaptive mode
+#define LE_ADMISSION_WINDOW_SEC 1.0
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int mode;
+    int limit;
+    int max_limit;
+    int active;
+    int parked;             //Threads that had to wait to be admitted
+    //Adaptive mode
+    int step;
+    int window_acquired;
+    double last_throughput;
+    struct timespec window_start;
+} le_admission_t;
+
+static le_admission_t le_admission;
+
+static double le_admission_elapsed(const struct timespec *since){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) + (now.tv_nsec - since->tv_nsec) / 1e9;
+}
+
+//Read LE_MAX_ACTIVE and set up the limiter
+static int le_admission_init(void){
+    const char *value = getenv("LE_MAX_ACTIVE");
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    memset(&le_admission, 0, sizeof(le_admission));
+    if (cpus <= 0) {
+        cpus = 1;
+    }
+
+    if (value == NULL || strcmp(value, "0") == 0 || strcmp(value, "off") == 0) {
+        le_admission.mode = LE_ADMISSION_OFF;
+    } else if (strcmp(value, "auto") == 0) {
+        le_admission.mode = LE_ADMISSION_FIXED;
+        le_admission.limit = cpus;
+    } else if (strcmp(value, "adaptive") == 0) {
+        le_admission.mode = LE_ADMISSION_ADAPTIVE;
+        le_admission.limit = cpus;
+        le_admission.max_limit = 4 * cpus;
+        le_admission.step = 1;
+        clock_gettime(CLOCK_MONOTONIC, &le_admission.window_start);
+    } else {
+        //The whole value must be the number, "4abc" is rejected instead of read as 4
+        char *end;
+        errno = 0;
+        long limit = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || errno != 0 || limit <= 0 || limit > INT_MAX) {
+            fprintf(stderr, "LE_MAX_ACTIVE must be a positive integer, auto, adaptive or off.\n");
+            return -1;
+        }
+        le_admission.mode = LE_ADMISSION_FIXED;
+        le_admission.limit = (int)limit;
+    }
+
+    if (pthread_mutex_init(&le_admission.mutex, NULL) != 0 ||
+        pthread_cond_init(&le_admission.cond, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize admission control.\n");
+        return -1;
+    }
+    return 0;
+}
+
+//Wait until the thread is allowed to contend for the lock
+static void le_admission_enter(void){
+    if (le_admission.mode == LE_ADMISSION_OFF) {
+        return;
+    }
+
+    pthread_mutex_lock(&le_admission.mutex);
+    if (le_admission.active >= le_admission.limit) {
+        le_admission.parked++;
+        while (le_admission.active >= le_admission.limit) {
+            pthread_cond_wait(&le_admission.cond, &le_admission.mutex);
+        }
+    }
+    le_admission.active++;
+    pthread_mutex_unlock(&le_admission.mutex);
+}
+
+//Move the limit one step and keep the direction while throughput improves, called with the mutex held
+static void le_admission_adapt(void){
+    double elapsed = le_admission_elapsed(&le_admission.window_start);
+    if (elapsed < LE_ADMISSION_WINDOW_SEC) {
+        return;
+    }
+
+    double throughput = le_admission.window_acquired / elapsed;
+    if (throughput < le_admission.last_throughput) {
+        le_admission.step = -le_admission.step;
+    }
+    le_admission.limit += le_admission.step;
+    if (le_admission.limit < 1) {
+        le_admission.limit = 1;
+    } else if (le_admission.limit > le_admission.max_limit) {
+        le_admission.limit = le_admission.max_limit;
+    }
+
+    le_admission.last_throughput = throughput;
+    le_admission.window_acquired = 0;
+    clock_gettime(CLOCK_MONOTONIC, &le_admission.window_start);
+    pthread_cond_broadcast(&le_admission.cond);
+}
+
+//Leave the set of contenders once the lock has been acquired
+static void le_admission_exit(void){
+    if (le_admission.mode == LE_ADMISSION_OFF) {
+        return;
+    }
+
+    pthread_mutex_lock(&le_admission.mutex);
+    le_admission.active--;
+    if (le_admission.mode == LE_ADMISSION_ADAPTIVE) {
+        le_admission.window_acquired++;
+        le_admission_adapt();
+    }
+    pthread_cond_signal(&le_admission.cond);
+    pthread_mutex_unlock(&le_admission.mutex);
+}
+
+//Print the limiter settings and how many threads were parked
+static void le_admission_print(void){
+    if (le_admission.mode == LE_ADMISSION_OFF) {
+        printf("Admission Limit: off\n");
+        return;
+    }
+    printf("Admission Limit: %d (%s)\n", le_admission.limit,
+        le_admission.mode == LE_ADMISSION_ADAPTIVE ? "adaptive" : "fixed");
+    printf("Admission Parked: %d\n", le_admission.parked);
+}
+
+static void le_admission_destroy(void){
+    if (le_admission.mode == LE_ADMISSION_OFF) {
+        return;
+    }
+    pthread_mutex_destroy(&le_admission.mutex);
+    pthread_cond_destroy(&le_admission.cond);
+}
+
+#endif
@@ -4,73 +4,97 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <time.h>
+#include "le_open_loop.h"
+#include "le_layout.h"
+#include "le_admission.h"
+#include "le_metrics.h"
 
 //This program implements a solution to the readers-writers problem using busy wait and mutex.
 //In this program, there is no priority between readers and writers, and they can run concurrently.
 
 //The program uses a mutex to manage access to shared resources and track the number of readers and writers.
-pthread_mutex_t t_mutex;
+pthread_mutex_t t_mutex LE_CACHE_ALIGNED;
 
 //Global variables to track execution time and completed operations
 struct timespec global_start_time, global_end_time;
 double total_execution_time_sec;
 
-int writing;
-int reader_count;
+//Shared state protected by the mutex
+struct {
+    int writing;
+    int reader_count;
+} LE_CACHE_ALIGNED shared;
+
+//Totals, summed from the per-thread statistics slots once all threads have finished
 int t_reads_completed;
 int t_writes_completed;
 
 //Reader and writer functions
 void* reader_func(void* arg){
-    int reader_id = *((int*)arg);
-    free(arg);
+    le_request_t *req = (le_request_t*)arg;
+    int reader_id = req->id;
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_READER, &acquire_start);
+    le_admission_enter();
 
     while(1){
         pthread_mutex_lock(&t_mutex);
-        if(!writing){
-            reader_count++;
+        if(!shared.writing){
+            shared.reader_count++;
             pthread_mutex_unlock(&t_mutex);
             break;
         }
         pthread_mutex_unlock(&t_mutex);
     }
+    le_admission_exit();
+    le_metrics_acquire_end(LE_ROLE_READER, &acquire_start);
 
     printf("Reader [%d] is reading...\n", reader_id);
     sleep(1 + rand() % 3);
     printf("Reader [%d] stop reading.\n", reader_id);
 
     pthread_mutex_lock(&t_mutex);
-    reader_count--;
-    t_reads_completed
-++;
+    shared.reader_count--;
     pthread_mutex_unlock(&t_mutex);
 
+    le_metrics_release(LE_ROLE_READER);
+    le_stats[req->index].reads_completed++;
+    le_complete_request(req);
     return NULL;
 }
 
 void* writer_func(void* arg){
-    int writer_id = *((int*)arg);
-    free(arg);
+    le_request_t *req = (le_request_t*)arg;
+    int writer_id = req->id;
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_WRITER, &acquire_start);
+    le_admission_enter();
 
     while(1){
         pthread_mutex_lock(&t_mutex);
-        if(reader_count == 0 && !writing){
-            writing = 1;
+        if(shared.reader_count == 0 && !shared.writing){
+            shared.writing = 1;
             pthread_mutex_unlock(&t_mutex);
             break;
         }
         pthread_mutex_unlock(&t_mutex);
     }
+    le_admission_exit();
+    le_metrics_acquire_end(LE_ROLE_WRITER, &acquire_start);
 
     printf("Writer [%d] is writing...\n", writer_id);
     sleep(1 + rand() % 3);
     printf("Writer [%d] stop writing.\n", writer_id);
 
     pthread_mutex_lock(&t_mutex);
-    t_writes_completed++;
-    writing = 0;
+    shared.writing = 0;
     pthread_mutex_unlock(&t_mutex);
 
+    le_metrics_release(LE_ROLE_WRITER);
+    le_stats[req->index].writes_completed++;
+    le_complete_request(req);
     return NULL;
 }
 
@@ -79,20 +103,17 @@ int main(int argc, char const *argv[]){
     //Initialize the global start time for execution time measurement
     clock_gettime(CLOCK_MONOTONIC, &global_start_time);
 
-    //Check command line arguments for number of readers and writers
-    if (argc < 3) {
-        printf("Usage: %s <num_readers> <num_writers>\n", argv[0]);
+    //Parse the command line: number of readers and writers, or open loop arrival rates
+    le_config_t cfg;
+    if (le_parse_args(argc, argv, &cfg) != 0) {
         return EXIT_FAILURE;
     }
 
-    //Parse the number of readers and writers from command line arguments
-    int num_readers = atoi(argv[1]);
-    int num_writers = atoi(argv[2]);
-    if (num_readers <= 0 || num_writers <= 0) {
-        fprintf(stderr, "Number of readers and writers must be positive integers.\n");
+    //Set up the optional admission control in front of the lock
+    if (le_admission_init() != 0) {
         return EXIT_FAILURE;
     }
-    
+
     //Initialize the mutex
     if (pthread_mutex_init(&t_mutex, NULL) != 0) {
         fprintf(stderr, "Mutex initialization failed.\n");
@@ -100,60 +121,74 @@ int main(int argc, char const *argv[]){
     }
 
     //Initialize global variables
-    writing = 0;
-    reader_count = 0;
+    shared.writing = 0;
+    shared.reader_count = 0;
     t_reads_completed = 0;
     t_writes_completed = 0;
 
-    //Allocate memory for threads
-    int total_threads = num_readers + num_writers;
+    //Seed the random number generator
+    srand(time(NULL));
+
+    //Build the schedule of readers and writers
+    if (le_build_schedule(&cfg) != 0) {
+        pthread_mutex_destroy(&t_mutex);
+        return EXIT_FAILURE;
+    }
+
+    //Allocate memory for threads and their statistics slots
+    int total_threads = le_schedule_len;
     pthread_t *threads;
     threads = malloc(total_threads * sizeof(pthread_t));
-    if (threads == NULL) {
+    if (threads == NULL || le_stats_init(total_threads) != 0) {
         fprintf(stderr, "Memory allocation failed.\n");
+        free(threads);
+        le_free_schedule();
         pthread_mutex_destroy(&t_mutex);
         return EXIT_FAILURE;
     }
-    
-    //Seed the random number generator
-    srand(time(NULL));
-    
-    //Variables to track the number of current readers and writers
-    int current_writers = 0;
-    int current_readers = 0;
 
-    //Create threads for readers and writers randomly
+    //Publish live metrics if LE_METRICS_SHM names a shared memory segment.
+    //Created last, so a failed setup does not leave a segment behind.
+    if (le_metrics_init(argv[0]) != 0) {
+        free(threads);
+        le_stats_free();
+        le_free_schedule();
+        pthread_mutex_destroy(&t_mutex);
+        return EXIT_FAILURE;
+    }
+
+    //Create threads for readers and writers following the schedule
+    le_start_clock();
     for (int i = 0; i < total_threads; i++){
-        int *arg = malloc(sizeof(int));
+        le_request_t *arg = le_next_request(&cfg, i);
         if (arg == NULL){
             fprintf(stderr, "Memory allocation failed.\n");
             for (int j = 0; j < i; j++) {
-                pthread_cancel(threads[j]);
+                if (le_request_started(j)) {
+                    pthread_cancel(threads[j]);
+                }
             }
             pthread_mutex_destroy(&t_mutex);
+            le_metrics_close();
             return EXIT_FAILURE;
         }
 
-        if (current_readers < num_readers && (current_writers == num_writers || rand() % 2 == 0)) {
-            *arg = current_readers;
-            pthread_create(&threads[i], NULL, reader_func, (void*)arg);
-            current_readers++;
-        } else if (current_writers < num_writers) {
-            *arg = current_writers;
-            pthread_create(&threads[i], NULL, writer_func, (void*)arg);
-            current_writers++;
-        } else {
-            free(arg);
-            fprintf(stderr, "No more readers or writers can be created.\n");
-            i--;
+        void *(*func)(void*) = le_schedule[i].role == LE_ROLE_READER ? reader_func : writer_func;
+        if (le_start_request(&threads[i], func, arg) != 0) {
+            continue;
         }
     }
 
     //Wait for all threads to finish
     for (int i = 0; i < total_threads; i++){
-        pthread_join(threads[i], NULL);
+        if (le_request_started(i)) {
+            pthread_join(threads[i], NULL);
+        }
     }
 
+    //Add up the completed operations of every thread
+    le_stats_sum(&t_reads_completed, &t_writes_completed);
+
     //Record the end time and calculate total execution time
     clock_gettime(CLOCK_MONOTONIC, &global_end_time);
     total_execution_time_sec = (global_end_time.tv_sec - global_start_time.tv_sec) +
@@ -161,6 +196,9 @@ int main(int argc, char const *argv[]){
     
     //Clean up resources
     free(threads);
+    le_stats_free();
+    le_admission_destroy();
+    le_metrics_close();
     pthread_mutex_destroy(&t_mutex);
 
     //Results
@@ -171,6 +209,10 @@ int main(int argc, char const *argv[]){
     printf("Writers Throughput: %.2f ops/seg\n", (double)t_writes_completed / total_execution_time_sec);      
     printf("Total Throughput: %.2f ops/seg\n", 
         (double)(t_reads_completed + t_writes_completed) /total_execution_time_sec);                   
+    printf("Memory Layout: %s\n", LE_LAYOUT_NAME);
+    le_admission_print();
+    le_print_load_results(&cfg);
+    le_free_schedule();
 
     return EXIT_SUCCESS;
-}
+}
\ No newline at end of file
@@ -0,0 +1,467 @@
+#define _GNU_SOURCE
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+#include<string.h>
+#include<pthread.h>
+#include<sched.h>
+#include<time.h>
+#include "le_open_loop.h"
+#include "le_layout.h"
+#include "le_admission.h"
+#include "le_metrics.h"
+
+//This program implements a solution to the readers-writers problem using a hierarchical (cohort) lock.
+//In this program, the writers are prioritized over the readers.
+
+//Writers take the local lock of their node (socket or cache domain) and then the global lock.
+//When a writer releases and another writer of the same node is waiting, the global lock is passed to it
+//without being released, up to COHORT_MAX_PASSES times in a row, so ownership stays between neighbouring cores.
+//Readers wait while the global lock is held or a writer is waiting for it.
+
+//Maximum number of consecutive local hand-offs before the global lock is released
+#define COHORT_MAX_PASSES 8
+
+//Maximum number of nodes
+#define COHORT_MAX_NODES 64
+
+//Local lock of a node
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int held;
+    int waiters;
+    int global_owned;       //The global lock was passed along with the local lock
+    int passes;             //Consecutive local hand-offs
+    int handoffs;           //Total local hand-offs of the node
+} LE_CACHE_ALIGNED cohort_node_t;
+
+cohort_node_t cohort_nodes[COHORT_MAX_NODES];
+int num_nodes;
+
+//Node of every CPU, read from /sys/devices/system/cpu
+int *cpu_node;
+int num_cpus;
+
+//Fake topology: number of nodes set with LE_FAKE_NODES, threads are spread round robin among them
+int fake_nodes;
+
+//Global lock
+pthread_mutex_t t_mutex LE_CACHE_ALIGNED;
+pthread_cond_t cond LE_CACHE_ALIGNED;
+
+//Global variables to track execution time and completed operations
+struct timespec global_start_time, global_end_time;
+double total_execution_time_sec;
+
+//Shared state protected by the global mutex
+struct {
+    int writing;
+    int writer_count;
+    int reader_count;
+    int finished;
+    int t_global_acquisitions;
+} LE_CACHE_ALIGNED shared;
+
+//Totals, summed from the per-thread statistics slots and the nodes once all threads have finished
+int t_reads_completed;
+int t_writes_completed;
+int t_local_handoffs;
+
+//Read the first integer of a sysfs file, returns -1 if it does not exist
+static int read_sysfs_int(const char *path){
+    FILE *f = fopen(path, "r");
+    int value;
+
+    if (f == NULL) {
+        return -1;
+    }
+    if (fscanf(f, "%d", &value) != 1) {
+        value = -1;
+    }
+    fclose(f);
+    return value;
+}
+
+//Id of the last level cache of a CPU: the id of the cache/index* entry with the highest level.
+//The index numbering is not fixed (index3 is not the LLC everywhere), returns -1 if it is unknown.
+static int read_llc_id(int cpu){
+    char path[256];
+    int best_level = -1;
+    int best_index = -1;
+
+    for (int index = 0; ; index++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+        int level = read_sysfs_int(path);
+        if (level < 0) {
+            break;
+        }
+        if (level > best_level) {
+            best_level = level;
+            best_index = index;
+        }
+    }
+    if (best_index < 0) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/id", cpu, best_index);
+    return read_sysfs_int(path);
+}
+
+//Build the CPU to node map. The node is the last level cache domain (LE_COHORT_DOMAIN=cache, default)
+//or the socket (LE_COHORT_DOMAIN=socket). CPUs without topology information go to node 0.
+static int load_topology(void){
+    const char *domain = getenv("LE_COHORT_DOMAIN");
+    const char *fake = getenv("LE_FAKE_NODES");
+    int use_socket = domain != NULL && strcmp(domain, "socket") == 0;
+    int domain_ids[COHORT_MAX_NODES];
+    char path[256];
+
+    num_nodes = 1;
+    if (fake != NULL) {
+        fake_nodes = atoi(fake);
+        if (fake_nodes <= 0 || fake_nodes > COHORT_MAX_NODES) {
+            fprintf(stderr, "LE_FAKE_NODES must be between 1 and %d.\n", COHORT_MAX_NODES);
+            return -1;
+        }
+        num_nodes = fake_nodes;
+        return 0;
+    }
+
+    num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (num_cpus <= 0) {
+        num_cpus = 1;
+    }
+    cpu_node = calloc(num_cpus, sizeof(int));
+    if (cpu_node == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return -1;
+    }
+
+    num_nodes = 0;
+    for (int cpu = 0; cpu < num_cpus; cpu++) {
+        int id = -1;
+        if (!use_socket) {
+            id = read_llc_id(cpu);
+        }
+        if (id < 0) {
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+            id = read_sysfs_int(path);
+        }
+        if (id < 0) {
+            id = 0;
+        }
+
+        int node = 0;
+        while (node < num_nodes && domain_ids[node] != id) {
+            node++;
+        }
+        if (node == num_nodes) {
+            if (num_nodes == COHORT_MAX_NODES) {
+                node = id % COHORT_MAX_NODES;
+            } else {
+                domain_ids[num_nodes++] = id;
+            }
+        }
+        cpu_node[cpu] = node;
+    }
+    if (num_nodes == 0) {
+        num_nodes = 1;
+    }
+    return 0;
+}
+
+//Node of the calling thread
+static int current_node(le_request_t *req){
+    if (fake_nodes > 0) {
+        return req->index % fake_nodes;
+    }
+
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= num_cpus) {
+        return 0;
+    }
+    return cpu_node[cpu];
+}
+
+//Reader and writer functions
+void* reader_func(void* arg){
+    le_request_t *req = (le_request_t*)arg;
+    int reader_id = req->id;
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_READER, &acquire_start);
+    le_admission_enter();
+
+    pthread_mutex_lock(&t_mutex);
+
+    while(!shared.finished){
+        pthread_cond_wait(&cond, &t_mutex);
+    }
+
+    while(shared.writing || shared.writer_count > 0){
+        pthread_cond_wait(&cond, &t_mutex);
+    }
+    shared.reader_count++;
+    pthread_mutex_unlock(&t_mutex);
+    le_admission_exit();
+    le_metrics_acquire_end(LE_ROLE_READER, &acquire_start);
+
+    //Simluate reading
+    printf("Reader [%d] is reading...\n", reader_id);
+    sleep(1 + rand() % 3);
+    printf("Reader [%d] stop reading.\n", reader_id);
+
+    pthread_mutex_lock(&t_mutex);
+    shared.reader_count--;
+    if(shared.reader_count == 0){
+        pthread_cond_broadcast(&cond);
+    }
+    pthread_mutex_unlock(&t_mutex);
+
+    le_metrics_release(LE_ROLE_READER);
+    le_stats[req->index].reads_completed++;
+    le_complete_request(req);
+    return NULL;
+}
+
+void* writer_func(void* arg){
+    le_request_t *req = (le_request_t*)arg;
+    int writer_id = req->id;
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_WRITER, &acquire_start);
+    le_admission_enter();
+
+    pthread_mutex_lock(&t_mutex);
+    while(!shared.finished){
+        pthread_cond_wait(&cond, &t_mutex);
+    }
+    shared.writer_count++;
+    pthread_mutex_unlock(&t_mutex);
+
+    //Acquire the local lock of the node
+    int node = current_node(req);
+    cohort_node_t *local = &cohort_nodes[node];
+
+    pthread_mutex_lock(&local->mutex);
+    local->waiters++;
+    while(local->held){
+        pthread_cond_wait(&local->cond, &local->mutex);
+    }
+    local->waiters--;
+    local->held = 1;
+    int has_global = local->global_owned;
+    pthread_mutex_unlock(&local->mutex);
+
+    //Acquire the global lock, unless a writer of the same node passed it along
+    pthread_mutex_lock(&t_mutex);
+    if(!has_global){
+        while(shared.writing || shared.reader_count > 0){
+            pthread_cond_wait(&cond, &t_mutex);
+        }
+        shared.writing = 1;
+        shared.t_global_acquisitions++;
+    }
+    shared.writer_count--;
+    pthread_mutex_unlock(&t_mutex);
+    le_admission_exit();
+    le_metrics_acquire_end(LE_ROLE_WRITER, &acquire_start);
+
+    //Simulate writing
+    printf("Writer [%d] is writing... (node %d)\n", writer_id, node);
+    sleep(1 + rand() % 3);
+    printf("Writer [%d] stop writing.\n", writer_id);
+
+    //Pass the global lock within the node while the fairness bound allows it, otherwise release it
+    pthread_mutex_lock(&local->mutex);
+    if(local->waiters > 0 && local->passes < COHORT_MAX_PASSES){
+        local->passes++;
+        local->global_owned = 1;
+        local->handoffs++;
+    } else {
+        local->passes = 0;
+        local->global_owned = 0;
+
+        pthread_mutex_lock(&t_mutex);
+        shared.writing = 0;
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&t_mutex);
+    }
+    local->held = 0;
+    pthread_cond_signal(&local->cond);
+    pthread_mutex_unlock(&local->mutex);
+
+    le_metrics_release(LE_ROLE_WRITER);
+    le_stats[req->index].writes_completed++;
+    le_complete_request(req);
+    return NULL;
+}
+
+int main(int argc, char const *argv[]){
+
+    //Initialize the global start time for execution time measurement
+    clock_gettime(CLOCK_MONOTONIC, &global_start_time);
+
+    //Parse the command line: number of readers and writers, or open loop arrival rates
+    le_config_t cfg;
+    if (le_parse_args(argc, argv, &cfg) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    //Set up the optional admission control in front of the lock
+    if (le_admission_init() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    //Discover the nodes of the machine, or use the fake topology
+    if (load_topology() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    //Initialize the global lock and the local lock of every node
+    if (pthread_mutex_init(&t_mutex, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize mutex.\n");
+        free(cpu_node);
+        return EXIT_FAILURE;
+    }
+    if (pthread_cond_init(&cond, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize condition variable.\n");
+        pthread_mutex_destroy(&t_mutex);
+        free(cpu_node);
+        return EXIT_FAILURE;
+    }
+    for (int n = 0; n < num_nodes; n++) {
+        memset(&cohort_nodes[n], 0, sizeof(cohort_node_t));
+        pthread_mutex_init(&cohort_nodes[n].mutex, NULL);
+        pthread_cond_init(&cohort_nodes[n].cond, NULL);
+    }
+
+    //Seed the random number generator
+    srand(time(NULL));
+
+    //Initialize global variables
+    shared.writing = 0;
+    shared.writer_count = 0;
+    shared.reader_count = 0;
+    t_reads_completed = 0;
+    t_writes_completed = 0;
+    shared.t_global_acquisitions = 0;
+    t_local_handoffs = 0;
+
+    //Build the schedule of readers and writers
+    if (le_build_schedule(&cfg) != 0) {
+        pthread_mutex_destroy(&t_mutex);
+        pthread_cond_destroy(&cond);
+        free(cpu_node);
+        return EXIT_FAILURE;
+    }
+
+    //Allocate memory for threads and their statistics slots
+    int total_threads = le_schedule_len;
+    pthread_t *threads;
+    threads = malloc(total_threads * sizeof(pthread_t));
+    if (threads == NULL || le_stats_init(total_threads) != 0) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        free(threads);
+        le_free_schedule();
+        pthread_mutex_destroy(&t_mutex);
+        pthread_cond_destroy(&cond);
+        free(cpu_node);
+        return EXIT_FAILURE;
+    }
+
+    //Initialize the finished flag
+    //In open loop the threads arrive over time, so they must not wait for a start signal
+    shared.finished = cfg.open_loop;
+
+    //Publish live metrics if LE_METRICS_SHM names a shared memory segment.
+    //Created last, so a failed setup does not leave a segment behind.
+    if (le_metrics_init(argv[0]) != 0) {
+        free(threads);
+        le_stats_free();
+        le_free_schedule();
+        pthread_mutex_destroy(&t_mutex);
+        pthread_cond_destroy(&cond);
+        free(cpu_node);
+        return EXIT_FAILURE;
+    }
+
+    //Create threads for readers and writers following the schedule
+    le_start_clock();
+    for (int i = 0; i < total_threads; i++){
+        le_request_t *arg = le_next_request(&cfg, i);
+        if (arg == NULL){
+            fprintf(stderr, "Memory allocation failed.\n");
+            for (int j = 0; j < i; j++) {
+                if (le_request_started(j)) {
+                    pthread_cancel(threads[j]);
+                }
+            }
+            pthread_mutex_destroy(&t_mutex);
+            le_metrics_close();
+            return EXIT_FAILURE;
+        }
+
+        void *(*func)(void*) = le_schedule[i].role == LE_ROLE_READER ? reader_func : writer_func;
+        if (le_start_request(&threads[i], func, arg) != 0) {
+            continue;
+        }
+    }
+
+    //Set the finished flag and signal all threads to start processing
+    pthread_mutex_lock(&t_mutex);
+    shared.finished = 1;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&t_mutex);
+
+    //Wait for all threads to finish
+    for (int i = 0; i < total_threads; i++){
+        if (le_request_started(i)) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    //Add up the completed operations of every thread and the local hand-offs of every node
+    le_stats_sum(&t_reads_completed, &t_writes_completed);
+    for (int n = 0; n < num_nodes; n++){
+        t_local_handoffs += cohort_nodes[n].handoffs;
+    }
+
+    //Record the end time and calculate total execution time
+    clock_gettime(CLOCK_MONOTONIC, &global_end_time);
+    total_execution_time_sec = (global_end_time.tv_sec - global_start_time.tv_sec) +
+                                (global_end_time.tv_nsec - global_start_time.tv_nsec) / 1e9;
+
+    //Clean up resources
+    for (int n = 0; n < num_nodes; n++) {
+        pthread_mutex_destroy(&cohort_nodes[n].mutex);
+        pthread_cond_destroy(&cohort_nodes[n].cond);
+    }
+    pthread_mutex_destroy(&t_mutex);
+    pthread_cond_destroy(&cond);
+    free(threads);
+    le_stats_free();
+    le_admission_destroy();
+    le_metrics_close();
+    free(cpu_node);
+
+    //Results
+    printf("\nReaders finished: %d\n", t_reads_completed);
+    printf("Writers finished: %d\n", t_writes_completed);
+    printf("Total execution time: %.4f seconds\n", total_execution_time_sec);
+    printf("Readers Throughput: %.2f ops/seg\n", (double)t_reads_completed / total_execution_time_sec);
+    printf("Writers Throughput: %.2f ops/seg\n", (double)t_writes_completed / total_execution_time_sec);
+    printf("Total Throughput: %.2f ops/seg\n",
+        (double)(t_reads_completed + t_writes_completed) /total_execution_time_sec);
+    printf("Cohort Nodes: %d%s\n", num_nodes, fake_nodes > 0 ? " (fake)" : "");
+    printf("Global Acquisitions: %d\n", shared.t_global_acquisitions);
+    printf("Local Hand-offs: %d\n", t_local_handoffs);
+    printf("Memory Layout: %s\n", LE_LAYOUT_NAME);
+    le_admission_print();
+    le_print_load_results(&cfg);
+    le_free_schedule();
+
+    return EXIT_SUCCESS;
+}
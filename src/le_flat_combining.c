@@ -0,0 +1,351 @@
+#define _XOPEN_SOURCE 700
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+#include<string.h>
+#include<pthread.h>
+#include<time.h>
+#include "le_open_loop.h"
+#include "le_layout.h"
+#include "le_admission.h"
+#include "le_metrics.h"
+
+//This program implements a solution to the readers-writers problem using flat combining for the writers.
+//In this program, the readers are prioritized over the writers, as in le_mutex_cond.
+
+//Instead of acquiring the exclusive lock one by one, every writer publishes its update in its own request slot.
+//The writer that gets the exclusive lock becomes the combiner: it applies all pending requests in one pass,
+//hands each writer its result and only then releases the lock, so a batch of writes costs one exclusive hand-off.
+pthread_mutex_t t_mutex LE_CACHE_ALIGNED;
+pthread_cond_t cond LE_CACHE_ALIGNED;
+
+//Global variables to track execution time and completed operations
+struct timespec global_start_time, global_end_time;
+double total_execution_time_sec;
+
+//Shared state protected by the mutex
+struct {
+    int writing;
+    int reader_count;
+    int t_exclusive_acquisitions;
+} LE_CACHE_ALIGNED shared;
+
+//Start flag, kept apart from the shared state
+struct {
+    int finished;
+} LE_CACHE_ALIGNED start;
+
+//Maximum number of requests applied in one combining pass, so readers are not locked out for a whole burst
+#define FC_MAX_BATCH 16
+
+//Shared resource, only modified by the combiner while it holds the exclusive lock
+int shared_version LE_CACHE_ALIGNED;
+
+//Request slot of a writer, one per thread
+typedef struct {
+    int pending;            //Set by the writer when it publishes, cleared by the combiner once applied
+    int writer_id;
+    int result;             //Version of the shared resource produced by this write
+    int combiner_id;
+} LE_CACHE_ALIGNED fc_slot_t;
+
+fc_slot_t *fc_slots;
+int fc_slots_len;
+
+//Totals, summed from the per-thread statistics slots once all threads have finished
+int t_reads_completed;
+int t_writes_completed;
+
+//Reader and writer functions
+void* reader_func(void* arg){
+    le_request_t *req = (le_request_t*)arg;
+    int reader_id = req->id;
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_READER, &acquire_start);
+    le_admission_enter();
+
+    pthread_mutex_lock(&t_mutex);
+
+    while(!start.finished){
+        pthread_cond_wait(&cond, &t_mutex); 
+    }
+
+    while(shared.writing){
+        pthread_cond_wait(&cond, &t_mutex);
+    }
+    shared.reader_count++;
+    pthread_mutex_unlock(&t_mutex);
+    le_admission_exit();
+    le_metrics_acquire_end(LE_ROLE_READER, &acquire_start);
+
+    //Simluate reading
+    printf("Reader [%d] is reading...\n", reader_id);
+    sleep(1 + rand() % 3);
+    printf("Reader [%d] stop reading.\n", reader_id);
+    
+    pthread_mutex_lock(&t_mutex);
+    
+    shared.reader_count--;
+    if(shared.reader_count == 0){
+        pthread_cond_broadcast(&cond);
+    }
+
+    pthread_mutex_unlock(&t_mutex);
+
+    le_metrics_release(LE_ROLE_READER);
+    le_stats[req->index].reads_completed++;
+    le_complete_request(req);
+    return NULL;
+}
+
+//Apply one pending request and hand the result back to its writer
+static void apply_write(fc_slot_t *slot, int combiner_id){
+    //Simulate writing
+    printf("Writer [%d] is writing... (combined by writer [%d])\n", slot->writer_id, combiner_id);
+    sleep(1 + rand() % 3);
+    printf("Writer [%d] stop writing.\n", slot->writer_id);
+
+    slot->result = ++shared_version;
+    slot->combiner_id = combiner_id;
+
+    //Wake the writer now instead of at the end of the pass, the combiner does not hold the mutex while combining
+    pthread_mutex_lock(&t_mutex);
+    __atomic_store_n(&slot->pending, 0, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&t_mutex);
+}
+
+//Apply the pending requests in one pass (up to FC_MAX_BATCH), called by the combiner with the exclusive lock held.
+//The combiner's own request goes first, so it never leaves the pass with its write still pending.
+static int combine_pending_writes(int own_index, int combiner_id){
+    int applied = 0;
+
+    apply_write(&fc_slots[own_index], combiner_id);
+    applied++;
+
+    for (int i = 0; i < fc_slots_len && applied < FC_MAX_BATCH; i++) {
+        fc_slot_t *slot = &fc_slots[i];
+        if (i == own_index || !__atomic_load_n(&slot->pending, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        apply_write(slot, combiner_id);
+        applied++;
+    }
+    return applied;
+}
+
+void* writer_func(void* arg){
+    le_request_t *req = (le_request_t*)arg;
+    int writer_id = req->id;
+    fc_slot_t *slot = &fc_slots[req->index];
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_WRITER, &acquire_start);
+    le_admission_enter();
+
+    //Publish the request
+    slot->writer_id = writer_id;
+    __atomic_store_n(&slot->pending, 1, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&t_mutex);
+
+    while(!start.finished){
+        pthread_cond_wait(&cond, &t_mutex);
+    }
+
+    //Wait until another combiner applies the request, or until the exclusive lock is free
+    while(__atomic_load_n(&slot->pending, __ATOMIC_ACQUIRE) && (shared.writing || shared.reader_count > 0)){
+        pthread_cond_wait(&cond, &t_mutex);
+    }
+
+    if(__atomic_load_n(&slot->pending, __ATOMIC_ACQUIRE)){
+        //Become the combiner
+        shared.writing = 1;
+        shared.t_exclusive_acquisitions++;
+        pthread_mutex_unlock(&t_mutex);
+        le_admission_exit();
+        le_metrics_acquire_end(LE_ROLE_WRITER, &acquire_start);
+
+        combine_pending_writes(req->index, writer_id);
+
+        pthread_mutex_lock(&t_mutex);
+        shared.writing = 0;
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&t_mutex);
+    } else {
+        //Another combiner applied the request
+        pthread_mutex_unlock(&t_mutex);
+        le_admission_exit();
+        le_metrics_acquire_end(LE_ROLE_WRITER, &acquire_start);
+    }
+
+    if(slot->combiner_id != writer_id){
+        printf("Writer [%d] got version %d from writer [%d].\n", writer_id, slot->result, slot->combiner_id);
+    }
+
+    le_metrics_release(LE_ROLE_WRITER);
+    le_stats[req->index].writes_completed++;
+    le_complete_request(req);
+    return NULL;
+}
+
+int main(int argc, char const *argv[]){
+
+    //Initialize the global start time for execution time measurement
+    clock_gettime(CLOCK_MONOTONIC, &global_start_time);
+    
+    //Parse the command line: number of readers and writers, or open loop arrival rates
+    le_config_t cfg;
+    if (le_parse_args(argc, argv, &cfg) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    //Set up the optional admission control in front of the lock
+    if (le_admission_init() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    //Initialize the mutex and condition variable
+    if (pthread_mutex_init(&t_mutex, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize mutex.\n");
+        return EXIT_FAILURE;
+    }
+    if (pthread_cond_init(&cond, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize condition variable.\n");
+        pthread_mutex_destroy(&t_mutex);
+        return EXIT_FAILURE;
+    }
+
+    //Seed the random number generator
+    srand(time(NULL));
+
+    //Initialize global variables
+    shared.writing = 0;
+    shared.reader_count = 0;
+    t_reads_completed = 0;
+    t_writes_completed = 0;
+    shared.t_exclusive_acquisitions = 0;
+    shared_version = 0;
+
+    //Build the schedule of readers and writers
+    if (le_build_schedule(&cfg) != 0) {
+        pthread_mutex_destroy(&t_mutex);
+        pthread_cond_destroy(&cond);
+        return EXIT_FAILURE;
+    }
+
+    //Allocate memory for threads and their statistics slots
+    int total_threads = le_schedule_len;
+    pthread_t *threads;
+    threads = malloc(total_threads * sizeof(pthread_t));
+    if (threads == NULL || le_stats_init(total_threads) != 0) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        free(threads);
+        le_free_schedule();
+        pthread_mutex_destroy(&t_mutex);
+        pthread_cond_destroy(&cond);
+        return EXIT_FAILURE;
+    }
+
+    //Allocate one request slot per thread
+    if (posix_memalign((void**)&fc_slots, LE_CACHE_LINE, total_threads * sizeof(fc_slot_t)) != 0) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        free(threads);
+        le_stats_free();
+        le_free_schedule();
+        pthread_mutex_destroy(&t_mutex);
+        pthread_cond_destroy(&cond);
+        return EXIT_FAILURE;
+    }
+    memset(fc_slots, 0, total_threads * sizeof(fc_slot_t));
+    fc_slots_len = total_threads;
+
+    //Initialize the finished flag
+    //In open loop the threads arrive over time, so they must not wait for a start signal
+    start.finished = cfg.open_loop;
+
+    //Publish live metrics if LE_METRICS_SHM names a shared memory segment.
+    //Created last, so a failed setup does not leave a segment behind.
+    if (le_metrics_init(argv[0]) != 0) {
+        free(threads);
+        free(fc_slots);
+        le_stats_free();
+        le_free_schedule();
+        pthread_mutex_destroy(&t_mutex);
+        pthread_cond_destroy(&cond);
+        return EXIT_FAILURE;
+    }
+
+    //Create threads for readers and writers following the schedule
+    le_start_clock();
+    for (int i = 0; i < total_threads; i++){
+        le_request_t *arg = le_next_request(&cfg, i);
+        if (arg == NULL){
+            fprintf(stderr, "Memory allocation failed.\n");
+            for (int j = 0; j < i; j++) {
+                if (le_request_started(j)) {
+                    pthread_cancel(threads[j]);
+                }
+            }
+            pthread_mutex_destroy(&t_mutex);
+            le_metrics_close();
+            return EXIT_FAILURE;
+        }
+
+        void *(*func)(void*) = le_schedule[i].role == LE_ROLE_READER ? reader_func : writer_func;
+        if (le_start_request(&threads[i], func, arg) != 0) {
+            continue;
+        }
+    }
+
+    //Set the finished flag and signal all threads to start processing
+    pthread_mutex_lock(&t_mutex);
+    start.finished = 1;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&t_mutex);
+    
+    //Wait for all threads to finish
+    for (int i = 0; i < total_threads; i++){
+        if (le_request_started(i)) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    //Add up the completed operations of every thread
+    le_stats_sum(&t_reads_completed, &t_writes_completed);
+
+    //Record the end time and calculate total execution time
+    clock_gettime(CLOCK_MONOTONIC, &global_end_time);
+    total_execution_time_sec = (global_end_time.tv_sec - global_start_time.tv_sec) + 
+                                (global_end_time.tv_nsec - global_start_time.tv_nsec) / 1e9;
+    
+    //Clean up resources
+    start.finished = 0;
+    pthread_mutex_destroy(&t_mutex);
+    pthread_cond_destroy(&cond);
+    free(threads);
+    le_stats_free();
+    le_admission_destroy();
+    le_metrics_close();
+    free(fc_slots);
+
+    //Results
+    printf("\nReaders finished: %d\n", t_reads_completed);
+    printf("Writers finished: %d\n", t_writes_completed);
+    printf("Total execution time: %.4f seconds\n", total_execution_time_sec); 
+    printf("Readers Throughput: %.2f ops/seg\n", (double)t_reads_completed / total_execution_time_sec);
+    printf("Writers Throughput: %.2f ops/seg\n", (double)t_writes_completed / total_execution_time_sec);      
+    printf("Total Throughput: %.2f ops/seg\n", 
+        (double)(t_reads_completed + t_writes_completed) /total_execution_time_sec);                   
+    printf("Exclusive Acquisitions: %d\n", shared.t_exclusive_acquisitions);
+    if (shared.t_exclusive_acquisitions > 0) {
+        printf("Writes per Acquisition: %.2f\n", (double)t_writes_completed / shared.t_exclusive_acquisitions);
+    }
+    printf("Memory Layout: %s\n", LE_LAYOUT_NAME);
+    le_admission_print();
+    le_print_load_results(&cfg);
+    le_free_schedule();
+    
+    return EXIT_SUCCESS;
+}
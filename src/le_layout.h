@@ -0,0 +1,60 @@
+#ifndef LE_LAYOUT_H
+#define LE_LAYOUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Memory layout of the lock state and the completion statistics.
+//Padded (default): every lock and the shared state it protects start on their own cache line, and every
+//thread counts its completed operations in a private slot one cache line wide. The slots are only summed
+//after all threads have been joined, so the counters are no longer bumped inside the critical section.
+//State that must share a cache line is grouped in a struct with LE_CACHE_ALIGNED: the type is then padded to
+//whole lines, while aligning only the first of several globals lets the linker place the others anywhere.
+//Packed (-DLE_PACKED_LAYOUT, `make packed`, built as bin/<program>_packed): no alignment and adjacent slots, to measure false sharing.
+
+#define LE_CACHE_LINE 64
+
+#ifdef LE_PACKED_LAYOUT
+#define LE_CACHE_ALIGNED
+#define LE_LAYOUT_NAME "packed"
+#else
+#define LE_CACHE_ALIGNED __attribute__((aligned(LE_CACHE_LINE)))
+#define LE_LAYOUT_NAME "padded"
+#endif
+
+//Statistics of a single thread
+typedef struct {
+    int reads_completed;
+    int writes_completed;
+} LE_CACHE_ALIGNED le_stats_slot_t;
+
+static le_stats_slot_t *le_stats;
+static int le_stats_len;
+
+//Allocate one zeroed statistics slot per thread
+static int le_stats_init(int slots){
+    if (posix_memalign((void**)&le_stats, LE_CACHE_LINE, slots * sizeof(le_stats_slot_t)) != 0) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return -1;
+    }
+    memset(le_stats, 0, slots * sizeof(le_stats_slot_t));
+    le_stats_len = slots;
+    return 0;
+}
+
+//Add up the slots of all threads, must be called after they have been joined
+static void le_stats_sum(int *reads, int *writes){
+    *reads = 0;
+    *writes = 0;
+    for (int i = 0; i < le_stats_len; i++) {
+        *reads += le_stats[i].reads_completed;
+        *writes += le_stats[i].writes_completed;
+    }
+}
+
+static void le_stats_free(void){
+    free(le_stats);
+}
+
+#endif
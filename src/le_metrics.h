@@ -0,0 +1,138 @@
+#ifndef LE_METRICS_H
+#define LE_METRICS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//Live metrics published in a shared memory segment while the program runs, so an external monitor (le_top)
+//can watch throughput, queue lengths and acquire latency develop instead of waiting for the final results.
+//Publishing is enabled by naming the segment with LE_METRICS_SHM (for example LE_METRICS_SHM=/le_metrics).
+//Counters are updated with relaxed atomics and no locking; a reader may see them slightly out of step.
+
+#define LE_METRICS_MAGIC 0x4c454d54
+#define LE_METRICS_VERSION 1
+
+//Acquire latency histogram: bucket i counts waits in [2^i, 2^(i+1)) microseconds, bucket 0 also takes shorter ones
+#define LE_METRICS_BUCKETS 32
+
+//Fixed alignment, the viewer must see the same layout whatever layout the program was built with
+#define LE_METRICS_ALIGNED __attribute__((aligned(64)))
+
+//Counters of one role (readers or writers), on their own cache lines
+typedef struct {
+    long completed;
+    long active;                //Holding the lock
+    long waiting;               //Queued for the lock, including admission control
+    long acquire_buckets[LE_METRICS_BUCKETS];
+} LE_METRICS_ALIGNED le_metrics_role_t;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    int pid;
+    int finished;               //Set when the run ends
+    char implementation[32];
+    le_metrics_role_t roles[2];   //Indexed by LE_ROLE_READER / LE_ROLE_WRITER
+} le_metrics_segment_t;
+
+static le_metrics_segment_t *le_metrics;
+static char le_metrics_name[64];
+
+//Create and map the segment named by LE_METRICS_SHM, does nothing if it is not set
+static inline int le_metrics_init(const char *program){
+    const char *name = getenv("LE_METRICS_SHM");
+
+    if (name == NULL || name[0] == '\0') {
+        return 0;
+    }
+    if (name[0] != '/' || strlen(name) >= sizeof(le_metrics_name)) {
+        fprintf(stderr, "LE_METRICS_SHM must start with '/' and be shorter than %zu characters.\n",
+            sizeof(le_metrics_name));
+        return -1;
+    }
+
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to create metrics segment %s.\n", name);
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(le_metrics_segment_t)) != 0) {
+        fprintf(stderr, "Failed to size metrics segment %s.\n", name);
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+    le_metrics = mmap(NULL, sizeof(le_metrics_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (le_metrics == MAP_FAILED) {
+        fprintf(stderr, "Failed to map metrics segment %s.\n", name);
+        le_metrics = NULL;
+        shm_unlink(name);
+        return -1;
+    }
+
+    strcpy(le_metrics_name, name);
+    const char *base = strrchr(program, '/');
+    strncpy(le_metrics->implementation, base != NULL ? base + 1 : program, sizeof(le_metrics->implementation) - 1);
+    le_metrics->pid = getpid();
+    le_metrics->version = LE_METRICS_VERSION;
+    __atomic_store_n(&le_metrics->magic, LE_METRICS_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+//A thread starts waiting for the lock
+static inline void le_metrics_acquire_begin(int role, struct timespec *start){
+    if (le_metrics == NULL) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, start);
+    __atomic_fetch_add(&le_metrics->roles[role].waiting, 1, __ATOMIC_RELAXED);
+}
+
+//A thread got the lock: move it from waiting to active and record how long it waited
+static inline void le_metrics_acquire_end(int role, const struct timespec *start){
+    if (le_metrics == NULL) {
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long wait_us = (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000;
+    int bucket = 0;
+    while (bucket < LE_METRICS_BUCKETS - 1 && wait_us >= (2L << bucket)) {
+        bucket++;
+    }
+
+    le_metrics_role_t *r = &le_metrics->roles[role];
+    __atomic_fetch_sub(&r->waiting, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&r->active, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&r->acquire_buckets[bucket], 1, __ATOMIC_RELAXED);
+}
+
+//A thread finished its operation
+static inline void le_metrics_release(int role){
+    if (le_metrics == NULL) {
+        return;
+    }
+    __atomic_fetch_sub(&le_metrics->roles[role].active, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&le_metrics->roles[role].completed, 1, __ATOMIC_RELAXED);
+}
+
+//Mark the run as finished and remove the segment name, a monitor that has it mapped keeps the last values
+static inline void le_metrics_close(void){
+    if (le_metrics == NULL) {
+        return;
+    }
+    __atomic_store_n(&le_metrics->finished, 1, __ATOMIC_RELEASE);
+    munmap(le_metrics, sizeof(le_metrics_segment_t));
+    shm_unlink(le_metrics_name);
+    le_metrics = NULL;
+}
+
+#endif
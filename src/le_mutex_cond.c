@@ -5,40 +5,59 @@
 #include<string.h>
 #include<pthread.h>
 #include<time.h>
+#include "le_open_loop.h"
+#include "le_layout.h"
+#include "le_admission.h"
+#include "le_metrics.h"
 
 //This program implements a solution to the readers-writers problem using mutexes and condition variables.
 //In this program, the readers are prioritized over the writers.
 
 //The program uses a mutex to manage access to shared resources and condition variables to signal when readers or writers can proceed.
-pthread_mutex_t t_mutex;
-pthread_cond_t cond;
+pthread_mutex_t t_mutex LE_CACHE_ALIGNED;
+pthread_cond_t cond LE_CACHE_ALIGNED;
 
 //Global variables to track execution time and completed operations
 struct timespec global_start_time, global_end_time;
 double total_execution_time_sec;
 
-int writing;
-int reader_count;
+//Shared state protected by the mutex
+struct {
+    int writing;
+    int reader_count;
+} LE_CACHE_ALIGNED shared;
+
+//Start flag, kept apart from the shared state
+struct {
+    int finished;
+} LE_CACHE_ALIGNED start;
+
+//Totals, summed from the per-thread statistics slots once all threads have finished
 int t_reads_completed;
 int t_writes_completed;
-int finished;
 
 //Reader and writer functions
 void* reader_func(void* arg){
-    int reader_id = *((int*)arg);
-    free(arg);
+    le_request_t *req = (le_request_t*)arg;
+    int reader_id = req->id;
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_READER, &acquire_start);
+    le_admission_enter();
 
     pthread_mutex_lock(&t_mutex);
 
-    while(!finished){
+    while(!start.finished){
         pthread_cond_wait(&cond, &t_mutex); 
     }
 
-    while(writing){
+    while(shared.writing){
         pthread_cond_wait(&cond, &t_mutex);
     }
-    reader_count++;
+    shared.reader_count++;
     pthread_mutex_unlock(&t_mutex);
+    le_admission_exit();
+    le_metrics_acquire_end(LE_ROLE_READER, &acquire_start);
 
     //Simluate reading
     printf("Reader [%d] is reading...\n", reader_id);
@@ -48,32 +67,40 @@ void* reader_func(void* arg){
     
     pthread_mutex_lock(&t_mutex);
     
-    t_reads_completed++;
-    reader_count--;
-    if(reader_count == 0){
+    shared.reader_count--;
+    if(shared.reader_count == 0){
         pthread_cond_signal(&cond);
     }
 
     pthread_mutex_unlock(&t_mutex);
 
+    le_metrics_release(LE_ROLE_READER);
+    le_stats[req->index].reads_completed++;
+    le_complete_request(req);
     return NULL;
 }
 
 void* writer_func(void* arg){
-    int writer_id = *((int*)arg);
-    free(arg);
+    le_request_t *req = (le_request_t*)arg;
+    int writer_id = req->id;
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_WRITER, &acquire_start);
+    le_admission_enter();
 
     pthread_mutex_lock(&t_mutex);
 
-    while(!finished){
+    while(!start.finished){
         pthread_cond_wait(&cond, &t_mutex);
     }
 
-    while(writing || reader_count > 0){
+    while(shared.writing || shared.reader_count > 0){
         pthread_cond_wait(&cond, &t_mutex);
     }
-    writing = 1;
+    shared.writing = 1;
     pthread_mutex_unlock(&t_mutex);
+    le_admission_exit();
+    le_metrics_acquire_end(LE_ROLE_WRITER, &acquire_start);
 
     //Simulate writing
     printf("Writer [%d] is writing...\n", writer_id);
@@ -82,12 +109,14 @@ void* writer_func(void* arg){
     
     pthread_mutex_lock(&t_mutex);
     
-    t_writes_completed++;
-    writing = 0;
+    shared.writing = 0;
     
     pthread_cond_broadcast(&cond);
     pthread_mutex_unlock(&t_mutex);
 
+    le_metrics_release(LE_ROLE_WRITER);
+    le_stats[req->index].writes_completed++;
+    le_complete_request(req);
     return NULL;
 }
 
@@ -96,17 +125,14 @@ int main(int argc, char const *argv[]){
     //Initialize the global start time for execution time measurement
     clock_gettime(CLOCK_MONOTONIC, &global_start_time);
     
-    //Check command line arguments for number of readers and writers
-    if (argc < 3) {
-        printf("Usage: %s <num_readers> <num_writers>\n", argv[0]);
+    //Parse the command line: number of readers and writers, or open loop arrival rates
+    le_config_t cfg;
+    if (le_parse_args(argc, argv, &cfg) != 0) {
         return EXIT_FAILURE;
     }
 
-    //Parse the number of readers and writers from command line arguments
-    int num_readers = atoi(argv[1]);
-    int num_writers = atoi(argv[2]);
-    if (num_readers <= 0 || num_writers <= 0) {
-        fprintf(stderr, "Number of readers and writers must be positive integers.\n");
+    //Set up the optional admission control in front of the lock
+    if (le_admission_init() != 0) {
         return EXIT_FAILURE;
     }
 
@@ -125,77 +151,97 @@ int main(int argc, char const *argv[]){
     srand(time(NULL));
 
     //Initialize global variables
-    writing = 0;
-    reader_count = 0;
+    shared.writing = 0;
+    shared.reader_count = 0;
     t_reads_completed = 0;
     t_writes_completed = 0;
 
-    //Allocate memory for threads
-    int total_threads = num_readers + num_writers;
+    //Build the schedule of readers and writers
+    if (le_build_schedule(&cfg) != 0) {
+        pthread_mutex_destroy(&t_mutex);
+        pthread_cond_destroy(&cond);
+        return EXIT_FAILURE;
+    }
+
+    //Allocate memory for threads and their statistics slots
+    int total_threads = le_schedule_len;
     pthread_t *threads;
     threads = malloc(total_threads * sizeof(pthread_t));
-    if (threads == NULL) {
+    if (threads == NULL || le_stats_init(total_threads) != 0) {
         fprintf(stderr, "Memory allocation failed.\n");
+        free(threads);
+        le_free_schedule();
         pthread_mutex_destroy(&t_mutex);
         pthread_cond_destroy(&cond);
         return EXIT_FAILURE;
     }
 
     //Initialize the finished flag
-    finished = 0;
-    
-    //Variables to track the number of current readers and writers
-    int current_writers = 0;
-    int current_readers = 0;
+    //In open loop the threads arrive over time, so they must not wait for a start signal
+    start.finished = cfg.open_loop;
 
-    //Create threads for readers and writers randomly
+    //Publish live metrics if LE_METRICS_SHM names a shared memory segment.
+    //Created last, so a failed setup does not leave a segment behind.
+    if (le_metrics_init(argv[0]) != 0) {
+        free(threads);
+        le_stats_free();
+        le_free_schedule();
+        pthread_mutex_destroy(&t_mutex);
+        pthread_cond_destroy(&cond);
+        return EXIT_FAILURE;
+    }
+
+    //Create threads for readers and writers following the schedule
+    le_start_clock();
     for (int i = 0; i < total_threads; i++){
-        int *arg = malloc(sizeof(int));
+        le_request_t *arg = le_next_request(&cfg, i);
         if (arg == NULL){
             fprintf(stderr, "Memory allocation failed.\n");
             for (int j = 0; j < i; j++) {
-                pthread_cancel(threads[j]);
+                if (le_request_started(j)) {
+                    pthread_cancel(threads[j]);
+                }
             }
             pthread_mutex_destroy(&t_mutex);
+            le_metrics_close();
             return EXIT_FAILURE;
         }
 
-        if (current_readers < num_readers && (current_writers == num_writers || rand() % 2 == 0)) {
-            *arg = current_readers;
-            pthread_create(&threads[i], NULL, reader_func, (void*)arg);
-            current_readers++;
-        } else if (current_writers < num_writers) {
-            *arg = current_writers;
-            pthread_create(&threads[i], NULL, writer_func, (void*)arg);
-            current_writers++;
-        } else {
-            free(arg);
-            fprintf(stderr, "No more readers or writers can be created.\n");
-            i--;
+        void *(*func)(void*) = le_schedule[i].role == LE_ROLE_READER ? reader_func : writer_func;
+        if (le_start_request(&threads[i], func, arg) != 0) {
+            continue;
         }
     }
 
-    //Set the finished flag to indicate that threads can start processing
-    finished = 1;
-
-    //Signal all threads to start processing
+    //Set the finished flag and signal all threads to start processing
+    pthread_mutex_lock(&t_mutex);
+    start.finished = 1;
     pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&t_mutex);
     
     //Wait for all threads to finish
     for (int i = 0; i < total_threads; i++){
-        pthread_join(threads[i], NULL);
+        if (le_request_started(i)) {
+            pthread_join(threads[i], NULL);
+        }
     }
 
+    //Add up the completed operations of every thread
+    le_stats_sum(&t_reads_completed, &t_writes_completed);
+
     //Record the end time and calculate total execution time
     clock_gettime(CLOCK_MONOTONIC, &global_end_time);
     total_execution_time_sec = (global_end_time.tv_sec - global_start_time.tv_sec) + 
                                 (global_end_time.tv_nsec - global_start_time.tv_nsec) / 1e9;
     
     //Clean up resources
-    finished = 0;
+    start.finished = 0;
     pthread_mutex_destroy(&t_mutex);
     pthread_cond_destroy(&cond);
     free(threads);
+    le_stats_free();
+    le_admission_destroy();
+    le_metrics_close();
 
     //Results
     printf("\nReaders finished: %d\n", t_reads_completed);
@@ -205,6 +251,10 @@ int main(int argc, char const *argv[]){
     printf("Writers Throughput: %.2f ops/seg\n", (double)t_writes_completed / total_execution_time_sec);      
     printf("Total Throughput: %.2f ops/seg\n", 
         (double)(t_reads_completed + t_writes_completed) /total_execution_time_sec);                   
+    printf("Memory Layout: %s\n", LE_LAYOUT_NAME);
+    le_admission_print();
+    le_print_load_results(&cfg);
+    le_free_schedule();
     
     return EXIT_SUCCESS;
 }
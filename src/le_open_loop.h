@@ -0,0 +1,361 @@
+#ifndef LE_OPEN_LOOP_H
+#define LE_OPEN_LOOP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+//Load generation shared by the readers-writers programs.
+//Closed loop: every reader and writer is created up front and released at the same time.
+//Open loop: readers and writers arrive over time at a target rate (Poisson or bursty arrivals).
+//In both modes the latency of a request is measured from its intended arrival time to its completion,
+//so a late dispatcher or a long queue is charged to the request instead of being hidden.
+
+#define LE_ROLE_READER 0
+#define LE_ROLE_WRITER 1
+
+#define LE_ARRIVAL_POISSON 0
+#define LE_ARRIVAL_BURSTY 1
+
+//Mean number of requests that arrive together in a burst (bursty model)
+#define LE_BURST_SIZE 5.0
+
+//Upper bound on the number of requests scheduled in a single open loop run
+#define LE_MAX_REQUESTS 200000
+
+//Stack size for the request threads, open loop runs can have thousands of them alive
+#define LE_THREAD_STACK_SIZE (256 * 1024)
+
+//Upper bound on the requests in flight in open loop. Past saturation arrivals beyond it are dropped and
+//reported instead of growing the number of live threads without bound.
+#define LE_MAX_IN_FLIGHT 4096
+
+//One entry of the arrival schedule
+typedef struct {
+    int role;
+    int id;
+    double arrival_sec;     //Offset from the start of the run
+} le_arrival_t;
+
+//Argument passed to every reader and writer thread
+typedef struct {
+    int id;
+    int index;              //Position in the schedule
+    struct timespec intended;
+} le_request_t;
+
+//Run configuration parsed from the command line
+typedef struct {
+    int open_loop;
+    int num_readers;
+    int num_writers;
+    double read_rate;
+    double write_rate;
+    double duration_sec;
+    int arrival_model;
+} le_config_t;
+
+static le_arrival_t *le_schedule;
+static int le_schedule_len;
+static double *le_latencies;
+static char *le_dropped;            //Requests whose thread was never started
+static int le_dropped_count;
+static int le_in_flight;
+static int le_open_loop_mode;
+static struct timespec le_base_time;
+static pthread_attr_t le_thread_attr;
+static unsigned short le_xsubi[3];
+
+static void le_usage(const char *prog){
+    printf("Usage: %s <num_readers> <num_writers>\n", prog);
+    printf("       %s --open-loop <read_rate> <write_rate> <duration_sec> [poisson|bursty]\n", prog);
+}
+
+//Parse either the closed loop or the open loop form of the command line
+static int le_parse_args(int argc, char const *argv[], le_config_t *cfg){
+    memset(cfg, 0, sizeof(*cfg));
+
+    if (argc >= 2 && strcmp(argv[1], "--open-loop") == 0) {
+        if (argc < 5) {
+            le_usage(argv[0]);
+            return -1;
+        }
+        cfg->open_loop = 1;
+        cfg->read_rate = atof(argv[2]);
+        cfg->write_rate = atof(argv[3]);
+        cfg->duration_sec = atof(argv[4]);
+        cfg->arrival_model = LE_ARRIVAL_POISSON;
+        if (argc >= 6) {
+            if (strcmp(argv[5], "bursty") == 0) {
+                cfg->arrival_model = LE_ARRIVAL_BURSTY;
+            } else if (strcmp(argv[5], "poisson") != 0) {
+                fprintf(stderr, "Unknown arrival model: %s\n", argv[5]);
+                return -1;
+            }
+        }
+        if (cfg->read_rate < 0 || cfg->write_rate < 0 || cfg->read_rate + cfg->write_rate <= 0 ||
+            cfg->duration_sec <= 0) {
+            fprintf(stderr, "Rates must be non-negative (not both zero) and duration must be positive.\n");
+            return -1;
+        }
+        return 0;
+    }
+
+    if (argc < 3) {
+        le_usage(argv[0]);
+        return -1;
+    }
+    cfg->num_readers = atoi(argv[1]);
+    cfg->num_writers = atoi(argv[2]);
+    if (cfg->num_readers <= 0 || cfg->num_writers <= 0) {
+        fprintf(stderr, "Number of readers and writers must be positive integers.\n");
+        return -1;
+    }
+    return 0;
+}
+
+//Exponential inter-arrival time for the given rate
+static double le_exp_sample(double rate){
+    return -log(1.0 - erand48(le_xsubi)) / rate;
+}
+
+//Append the arrivals of one role up to the end of the run, returns the number of arrivals
+static int le_generate_arrivals(const le_config_t *cfg, int role, double rate, int *len){
+    int count = 0;
+    double t = 0;
+
+    if (rate <= 0) {
+        return 0;
+    }
+
+    while (1) {
+        int burst = 1;
+        if (cfg->arrival_model == LE_ARRIVAL_BURSTY) {
+            //Bursts arrive as a Poisson process, each one carries a geometric number of requests
+            t += le_exp_sample(rate / LE_BURST_SIZE);
+            while (erand48(le_xsubi) < 1.0 - 1.0 / LE_BURST_SIZE) {
+                burst++;
+            }
+        } else {
+            t += le_exp_sample(rate);
+        }
+        if (t >= cfg->duration_sec) {
+            break;
+        }
+        for (int b = 0; b < burst; b++) {
+            if (*len == LE_MAX_REQUESTS) {
+                fprintf(stderr, "Too many requests, lower the rates or the duration.\n");
+                return -1;
+            }
+            le_schedule[*len].role = role;
+            le_schedule[*len].id = count++;
+            le_schedule[*len].arrival_sec = t;
+            (*len)++;
+        }
+    }
+    return count;
+}
+
+static int le_compare_arrivals(const void *a, const void *b){
+    double ta = ((const le_arrival_t*)a)->arrival_sec;
+    double tb = ((const le_arrival_t*)b)->arrival_sec;
+    return (ta > tb) - (ta < tb);
+}
+
+//Build the schedule of requests. Must be called after srand().
+//In closed loop readers and writers are interleaved randomly and all arrive at time zero.
+static int le_build_schedule(le_config_t *cfg){
+    int len = 0;
+
+    if (!cfg->open_loop) {
+        int total = cfg->num_readers + cfg->num_writers;
+        le_schedule = malloc(total * sizeof(le_arrival_t));
+        if (le_schedule == NULL) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            return -1;
+        }
+
+        int current_readers = 0;
+        int current_writers = 0;
+        while (len < total) {
+            if (current_readers < cfg->num_readers &&
+                (current_writers == cfg->num_writers || rand() % 2 == 0)) {
+                le_schedule[len].role = LE_ROLE_READER;
+                le_schedule[len].id = current_readers++;
+            } else {
+                le_schedule[len].role = LE_ROLE_WRITER;
+                le_schedule[len].id = current_writers++;
+            }
+            le_schedule[len].arrival_sec = 0;
+            len++;
+        }
+    } else {
+        le_schedule = malloc(LE_MAX_REQUESTS * sizeof(le_arrival_t));
+        if (le_schedule == NULL) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            return -1;
+        }
+
+        le_xsubi[0] = (unsigned short)rand();
+        le_xsubi[1] = (unsigned short)rand();
+        le_xsubi[2] = (unsigned short)rand();
+        cfg->num_readers = le_generate_arrivals(cfg, LE_ROLE_READER, cfg->read_rate, &len);
+        cfg->num_writers = le_generate_arrivals(cfg, LE_ROLE_WRITER, cfg->write_rate, &len);
+        if (cfg->num_readers < 0 || cfg->num_writers < 0) {
+            free(le_schedule);
+            return -1;
+        }
+        if (len == 0) {
+            fprintf(stderr, "No requests were generated, increase the rates or the duration.\n");
+            free(le_schedule);
+            return -1;
+        }
+        qsort(le_schedule, len, sizeof(le_arrival_t), le_compare_arrivals);
+    }
+
+    le_latencies = calloc(len, sizeof(double));
+    le_dropped = calloc(len, sizeof(char));
+    if (le_latencies == NULL || le_dropped == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        free(le_latencies);
+        free(le_dropped);
+        free(le_schedule);
+        return -1;
+    }
+    le_dropped_count = 0;
+    le_in_flight = 0;
+    le_open_loop_mode = cfg->open_loop;
+
+    pthread_attr_init(&le_thread_attr);
+    pthread_attr_setstacksize(&le_thread_attr, LE_THREAD_STACK_SIZE);
+
+    le_schedule_len = len;
+    return 0;
+}
+
+//Mark the start of the run, arrival offsets are relative to this instant
+static void le_start_clock(void){
+    clock_gettime(CLOCK_MONOTONIC, &le_base_time);
+}
+
+//Build the argument of request i. In open loop, sleep until its intended arrival time first.
+static le_request_t *le_next_request(const le_config_t *cfg, int i){
+    le_request_t *req = malloc(sizeof(le_request_t));
+    if (req == NULL) {
+        return NULL;
+    }
+
+    double offset = le_schedule[i].arrival_sec;
+    req->id = le_schedule[i].id;
+    req->index = i;
+    req->intended.tv_sec = le_base_time.tv_sec + (time_t)offset;
+    req->intended.tv_nsec = le_base_time.tv_nsec + (long)((offset - (time_t)offset) * 1e9);
+    if (req->intended.tv_nsec >= 1000000000L) {
+        req->intended.tv_sec++;
+        req->intended.tv_nsec -= 1000000000L;
+    }
+
+    if (cfg->open_loop) {
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &req->intended, NULL) == EINTR);
+    }
+    return req;
+}
+
+//Start the thread of a request. Returns 0 on success; otherwise the request is counted as dropped,
+//its argument is released and its thread must not be joined (see le_request_started).
+static int le_start_request(pthread_t *thread, void *(*func)(void*), le_request_t *req){
+    if (le_open_loop_mode && __atomic_load_n(&le_in_flight, __ATOMIC_RELAXED) >= LE_MAX_IN_FLIGHT) {
+        le_dropped[req->index] = 1;
+        le_dropped_count++;
+        free(req);
+        return -1;
+    }
+
+    __atomic_fetch_add(&le_in_flight, 1, __ATOMIC_RELAXED);
+    if (pthread_create(thread, &le_thread_attr, func, (void*)req) != 0) {
+        __atomic_fetch_sub(&le_in_flight, 1, __ATOMIC_RELAXED);
+        le_dropped[req->index] = 1;
+        le_dropped_count++;
+        free(req);
+        return -1;
+    }
+    return 0;
+}
+
+//Whether the thread of request i was started and has to be joined
+static int le_request_started(int i){
+    return !le_dropped[i];
+}
+
+//Record the latency of a finished request and release its argument
+static void le_complete_request(le_request_t *req){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    le_latencies[req->index] = (now.tv_sec - req->intended.tv_sec) +
+                               (now.tv_nsec - req->intended.tv_nsec) / 1e9;
+    __atomic_fetch_sub(&le_in_flight, 1, __ATOMIC_RELAXED);
+    free(req);
+}
+
+static int le_compare_doubles(const void *a, const void *b){
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+//Print latency percentiles of one role
+static void le_print_role_latency(int role, const char *label){
+    double *values = malloc(le_schedule_len * sizeof(double));
+    int n = 0;
+    int dropped = 0;
+
+    if (values == NULL) {
+        return;
+    }
+    for (int i = 0; i < le_schedule_len; i++) {
+        if (le_schedule[i].role == role && le_dropped[i]) {
+            dropped++;
+        } else if (le_schedule[i].role == role) {
+            values[n++] = le_latencies[i];
+        }
+    }
+    if (n > 0) {
+        qsort(values, n, sizeof(double), le_compare_doubles);
+        printf("%s Latency p50: %.4f seconds\n", label, values[(int)(0.50 * (n - 1))]);
+        printf("%s Latency p95: %.4f seconds\n", label, values[(int)(0.95 * (n - 1))]);
+        printf("%s Latency p99: %.4f seconds\n", label, values[(int)(0.99 * (n - 1))]);
+        printf("%s Latency max: %.4f seconds\n", label, values[n - 1]);
+    }
+    if (dropped > 0) {
+        printf("%s Latency excludes %d dropped arrivals\n", label, dropped);
+    }
+    free(values);
+}
+
+//Print the open loop parameters and the latency results
+static void le_print_load_results(const le_config_t *cfg){
+    if (cfg->open_loop) {
+        printf("Offered Load: %.2f ops/seg\n", cfg->read_rate + cfg->write_rate);
+        printf("Arrival Model: %s\n", cfg->arrival_model == LE_ARRIVAL_BURSTY ? "bursty" : "poisson");
+    }
+    if (le_dropped_count > 0) {
+        printf("Dropped Arrivals: %d (over %d requests in flight, not in the latency percentiles)\n",
+            le_dropped_count, LE_MAX_IN_FLIGHT);
+    }
+    le_print_role_latency(LE_ROLE_READER, "Readers");
+    le_print_role_latency(LE_ROLE_WRITER, "Writers");
+}
+
+//Release the schedule and the latency samples
+static void le_free_schedule(void){
+    pthread_attr_destroy(&le_thread_attr);
+    free(le_latencies);
+    free(le_dropped);
+    free(le_schedule);
+}
+
+#endif
@@ -6,42 +6,58 @@
 #include <pthread.h>
 #include <time.h>
 #include <semaphore.h>
+#include "le_open_loop.h"
+#include "le_layout.h"
+#include "le_admission.h"
+#include "le_metrics.h"
 
 // This program implements a solution to the readers-writers problem using semaphores.
 // In this program, the writers are prioritized over the readers.
 
 //The prgram uses semaphores to synchronize access to shared resources.
-sem_t start_sem;
-sem_t mutex;
-sem_t write_sem;
-sem_t read_sem;
+sem_t start_sem LE_CACHE_ALIGNED;
+sem_t mutex LE_CACHE_ALIGNED;
+sem_t write_sem LE_CACHE_ALIGNED;
+sem_t read_sem LE_CACHE_ALIGNED;
 
 //Global variables to track execution time and completed operations
 struct timespec global_start_time, global_end_time;
 double total_execution_time_sec;
 
+//Shared state protected by the mutex semaphore
+struct {
+    int writing;
+    int writer_count;
+    int reader_count;
+    int readers_waiting;     //Readers blocked on read_sem, each one needs exactly one post
+} LE_CACHE_ALIGNED shared;
+
+//Totals, summed from the per-thread statistics slots once all threads have finished
 int t_reads_completed;
 int t_writes_completed;
-int writing;
-int writer_count;
-int reader_count;
-int num_readers;
 
 //Reader and writer functions
 void * reader_func(void* arg){
     sem_wait(&start_sem);
 
-    int reader_id = *((int*)arg);
-    free(arg);
+    le_request_t *req = (le_request_t*)arg;
+    int reader_id = req->id;
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_READER, &acquire_start);
+    le_admission_enter();
 
     sem_wait(&mutex);
-    while(writer_count > 0 || writing){
+    while(shared.writer_count > 0 || shared.writing){
+        shared.readers_waiting++;
         sem_post(&mutex);
         sem_wait(&read_sem);
         sem_wait(&mutex);
     }
-    reader_count++;
+    shared.reader_count++;
     sem_post(&mutex);
+    le_admission_exit();
+    le_metrics_acquire_end(LE_ROLE_READER, &acquire_start);
 
     //Simluate reading
     printf("Reader [%d] is reading...\n", reader_id);
@@ -49,31 +65,40 @@ void * reader_func(void* arg){
     printf("Reader [%d] stop reading.\n", reader_id);
 
     sem_wait(&mutex);
-    t_reads_completed++;
-    reader_count--;
-    if(reader_count == 0 || writer_count > 0){
+    shared.reader_count--;
+    if(shared.reader_count == 0 || shared.writer_count > 0){
         sem_post(&write_sem);
     }
     sem_post(&mutex);
+
+    le_metrics_release(LE_ROLE_READER);
+    le_stats[req->index].reads_completed++;
+    le_complete_request(req);
     return NULL;
 }
 
 void * writer_func(void* arg){
     sem_wait(&start_sem);
 
-    int writer_id = *((int*)arg);
-    free(arg);
+    le_request_t *req = (le_request_t*)arg;
+    int writer_id = req->id;
+
+    struct timespec acquire_start;
+    le_metrics_acquire_begin(LE_ROLE_WRITER, &acquire_start);
+    le_admission_enter();
 
     sem_wait(&mutex);
 
-    writer_count++;
-    while(reader_count > 0 || writing){
+    shared.writer_count++;
+    while(shared.reader_count > 0 || shared.writing){
         sem_post(&mutex);
         sem_wait(&write_sem);
         sem_wait(&mutex);
     }
-    writing = 1;
+    shared.writing = 1;
     sem_post(&mutex);
+    le_admission_exit();
+    le_metrics_acquire_end(LE_ROLE_WRITER, &acquire_start);
     
     //Simulate writing
     printf("Writer [%d] is writing...\n", writer_id);
@@ -81,18 +106,22 @@ void * writer_func(void* arg){
     printf("Writer [%d] stop writing.\n", writer_id);
     
     sem_wait(&mutex);
-    writer_count--;
-    t_writes_completed++;
-    writing = 0;
-    if(writer_count > 0){
+    shared.writer_count--;
+    shared.writing = 0;
+    if(shared.writer_count > 0){
         sem_post(&write_sem);
     } else {
-        for (int i = 0; i < num_readers; i++){
+        //Release only the readers that are blocked, so no permits are left over
+        for (int i = 0; i < shared.readers_waiting; i++){
             sem_post(&read_sem);
         }
+        shared.readers_waiting = 0;
     }
     sem_post(&mutex);
 
+    le_metrics_release(LE_ROLE_WRITER);
+    le_stats[req->index].writes_completed++;
+    le_complete_request(req);
     return NULL;
 }
 
@@ -101,22 +130,18 @@ int main(int argc, char const *argv[]){
     //Initialize global start time for execution time measurement
     clock_gettime(CLOCK_MONOTONIC, &global_start_time);
 
-    //Cheack command line arguments for number of readers and writers
-    if(argc < 3){
-        printf("Usage: %s <num_readers> <num_writers>\n", argv[0]);
+    //Parse the command line: number of readers and writers, or open loop arrival rates
+    le_config_t cfg;
+    if(le_parse_args(argc, argv, &cfg) != 0){
         return EXIT_FAILURE;
     }
 
-    //Parse the number of readers and writers from command line arguments
-    num_readers = atoi(argv[1]);
-    int num_writers = atoi(argv[2]);
-    if(num_readers <= 0 || num_writers <= 0){
-        fprintf(stderr, "Number of readers and writers must be positive integers.\n");
+    //Set up the optional admission control in front of the lock
+    if (le_admission_init() != 0) {
         return EXIT_FAILURE;
     }
 
     //Initialize semaphores
-    int total_threads = num_readers + num_writers;
     if (sem_init(&start_sem, 0, 0) != 0) {
         fprintf(stderr, "Failed to initialize start semaphore.\n");
         return EXIT_FAILURE;
@@ -140,10 +165,25 @@ int main(int argc, char const *argv[]){
         return EXIT_FAILURE;
     }
 
-    //Allocate memory for thread identifiers
+    //Seed the random number generator
+    srand(time(NULL));
+
+    //Build the schedule of readers and writers
+    if (le_build_schedule(&cfg) != 0) {
+        sem_destroy(&read_sem);
+        sem_destroy(&write_sem);
+        sem_destroy(&mutex);
+        sem_destroy(&start_sem);
+        return EXIT_FAILURE;
+    }
+
+    //Allocate memory for thread identifiers and their statistics slots
+    int total_threads = le_schedule_len;
     pthread_t *threads = malloc(total_threads * sizeof(pthread_t));
-    if (threads == NULL) {
+    if (threads == NULL || le_stats_init(total_threads) != 0) {
         fprintf(stderr, "Memory allocation failed.\n");
+        free(threads);
+        le_free_schedule();
         sem_destroy(&read_sem);
         sem_destroy(&write_sem);
         sem_destroy(&mutex);
@@ -151,61 +191,77 @@ int main(int argc, char const *argv[]){
         return EXIT_FAILURE;
     }
 
-    //Seed the random number generator
-    srand(time(NULL));
-
     //Initialize global variables
     t_reads_completed = 0;
     t_writes_completed = 0;
-    writing = 0;
-    writer_count = 0;
-    reader_count = 0;
+    shared.writing = 0;
+    shared.writer_count = 0;
+    shared.reader_count = 0;
+    shared.readers_waiting = 0;
 
-    //Variables to track the number of current readers and writers
-    int current_writers = 0;
-    int current_readers = 0;
+    //Publish live metrics if LE_METRICS_SHM names a shared memory segment.
+    //Created last, so a failed setup does not leave a segment behind.
+    if (le_metrics_init(argv[0]) != 0) {
+        free(threads);
+        le_stats_free();
+        le_free_schedule();
+        sem_destroy(&read_sem);
+        sem_destroy(&write_sem);
+        sem_destroy(&mutex);
+        sem_destroy(&start_sem);
+        return EXIT_FAILURE;
+    }
 
-    //Create threads for readers and writers randomly
+    //Create threads for readers and writers following the schedule
+    le_start_clock();
     for (int i = 0; i < total_threads; i++){
-        int *arg = malloc(sizeof(int));
+        le_request_t *arg = le_next_request(&cfg, i);
         if (arg == NULL){
             fprintf(stderr, "Memory allocation failed.\n");
             for (int j = 0; j < i; j++) {
-                pthread_cancel(threads[j]);
+                if (le_request_started(j)) {
+                    pthread_cancel(threads[j]);
+                }
             }
             sem_destroy(&read_sem);
             sem_destroy(&write_sem);
             sem_destroy(&mutex);
             sem_destroy(&start_sem);
             free(threads);
+            le_metrics_close();
             return EXIT_FAILURE;
         }
 
-        if (current_readers < num_readers && (current_writers == num_writers || rand() % 2 == 0)) {
-            *arg = current_readers;
-            pthread_create(&threads[i], NULL, reader_func, (void*)arg);
-            current_readers++;
-        } else if (current_writers < num_writers) {
-            *arg = current_writers;
-            pthread_create(&threads[i], NULL, writer_func, (void*)arg);
-            current_writers++;
-        } else {
-            free(arg);
-            fprintf(stderr, "No more readers or writers can be created.\n");
-            i--;
+        void *(*func)(void*) = le_schedule[i].role == LE_ROLE_READER ? reader_func : writer_func;
+        if (le_start_request(&threads[i], func, arg) != 0) {
+            continue;
+        }
+
+        //In open loop every thread starts as soon as it arrives
+        if (cfg.open_loop) {
+            sem_post(&start_sem);
         }
     }
 
-    //Release all threads to start
-    for (int i = 0; i < total_threads; i++) {
-        sem_post(&start_sem);
+    //Release all the started threads
+    if (!cfg.open_loop) {
+        for (int i = 0; i < total_threads; i++) {
+            if (le_request_started(i)) {
+                sem_post(&start_sem);
+            }
+        }
     }
 
     //Wait for all threads to finish
     for (int i = 0; i < total_threads; i++){
-        pthread_join(threads[i], NULL);
+        if (le_request_started(i)) {
+            pthread_join(threads[i], NULL);
+        }
     }
 
+    //Add up the completed operations of every thread
+    le_stats_sum(&t_reads_completed, &t_writes_completed);
+
     //Record the end time for execution time measurement
     clock_gettime(CLOCK_MONOTONIC, &global_end_time);
     total_execution_time_sec = (global_end_time.tv_sec - global_start_time.tv_sec) +
@@ -217,6 +273,9 @@ int main(int argc, char const *argv[]){
     sem_destroy(&mutex);
     sem_destroy(&start_sem);
     free(threads);
+    le_stats_free();
+    le_admission_destroy();
+    le_metrics_close();
 
     //Results
     printf("\nReaders finished: %d\n", t_reads_completed);
@@ -226,6 +285,10 @@ int main(int argc, char const *argv[]){
     printf("Writers Throughput: %.2f ops/seg\n", (double)t_writes_completed / total_execution_time_sec);      
     printf("Total Throughput: %.2f ops/seg\n", 
         (double)(t_reads_completed + t_writes_completed) /total_execution_time_sec); 
+    printf("Memory Layout: %s\n", LE_LAYOUT_NAME);
+    le_admission_print();
+    le_print_load_results(&cfg);
+    le_free_schedule();
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include "le_metrics.h"
+
+//This program samples the live metrics segment of a running readers-writers program once per second.
+//Usage: le_top [segment_name] (default /le_metrics), the program must run with LE_METRICS_SHM set to the same name.
+//Each line shows the throughput of the last second, how many readers and writers hold or wait for the lock,
+//and the acquire latency percentiles since the start. A role that has had waiting threads and no completed
+//operations for STARVATION_SEC seconds in a row is flagged as starving.
+//The viewer stops when the run finishes, or when the program exits without finishing it (for example on Ctrl-C).
+
+#define DEFAULT_SEGMENT "/le_metrics"
+
+//Same indices as LE_ROLE_READER and LE_ROLE_WRITER
+#define ROLE_READER 0
+#define ROLE_WRITER 1
+
+#define STARVATION_SEC 5
+
+//Upper bound, in milliseconds, of the bucket that holds the given percentile of the acquire latency
+static double bucket_percentile(const le_metrics_role_t *r, double percentile){
+    long total = 0;
+    long seen = 0;
+
+    for (int i = 0; i < LE_METRICS_BUCKETS; i++) {
+        total += __atomic_load_n(&r->acquire_buckets[i], __ATOMIC_RELAXED);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    for (int i = 0; i < LE_METRICS_BUCKETS; i++) {
+        seen += __atomic_load_n(&r->acquire_buckets[i], __ATOMIC_RELAXED);
+        if (seen >= percentile * total) {
+            return (2L << i) / 1000.0;
+        }
+    }
+    return (2L << (LE_METRICS_BUCKETS - 1)) / 1000.0;
+}
+
+int main(int argc, char const *argv[]){
+    const char *name = argc >= 2 ? argv[1] : DEFAULT_SEGMENT;
+
+    //Wait for the program to create the segment
+    int fd;
+    while ((fd = shm_open(name, O_RDONLY, 0)) < 0) {
+        fprintf(stderr, "Waiting for metrics segment %s...\n", name);
+        sleep(1);
+    }
+
+    le_metrics_segment_t *segment = mmap(NULL, sizeof(le_metrics_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        fprintf(stderr, "Failed to map metrics segment %s.\n", name);
+        return EXIT_FAILURE;
+    }
+
+    //The segment may have been created but not filled in yet
+    while (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != LE_METRICS_MAGIC) {
+        sleep(1);
+    }
+    if (segment->version != LE_METRICS_VERSION) {
+        fprintf(stderr, "Unsupported metrics segment version %u.\n", segment->version);
+        munmap(segment, sizeof(le_metrics_segment_t));
+        return EXIT_FAILURE;
+    }
+
+    printf("Monitoring %s (pid %d) through %s\n", segment->implementation, segment->pid, name);
+    printf("%6s | %8s %6s %6s %9s %9s | %8s %6s %6s %9s %9s\n",
+        "time", "reads/s", "active", "wait", "p50 ms", "p99 ms",
+        "writes/s", "active", "wait", "p50 ms", "p99 ms");
+
+    long last_completed[2] = {0, 0};
+    int stalled_sec[2] = {0, 0};
+    int elapsed = 0;
+    int finished = 0;
+
+    while (!finished) {
+        sleep(1);
+        elapsed++;
+        finished = __atomic_load_n(&segment->finished, __ATOMIC_ACQUIRE);
+        if (!finished && kill(segment->pid, 0) != 0 && errno == ESRCH) {
+            printf("Program (pid %d) exited without finishing the run\n", segment->pid);
+            break;
+        }
+
+        long rate[2];
+        long active[2];
+        long waiting[2];
+        for (int role = 0; role < 2; role++) {
+            const le_metrics_role_t *r = &segment->roles[role];
+            long completed = __atomic_load_n(&r->completed, __ATOMIC_RELAXED);
+            rate[role] = completed - last_completed[role];
+            last_completed[role] = completed;
+            active[role] = __atomic_load_n(&r->active, __ATOMIC_RELAXED);
+            waiting[role] = __atomic_load_n(&r->waiting, __ATOMIC_RELAXED);
+            stalled_sec[role] = (waiting[role] > 0 && rate[role] == 0) ? stalled_sec[role] + 1 : 0;
+        }
+
+        printf("%5ds | %8ld %6ld %6ld %9.1f %9.1f | %8ld %6ld %6ld %9.1f %9.1f",
+            elapsed,
+            rate[ROLE_READER], active[ROLE_READER], waiting[ROLE_READER],
+            bucket_percentile(&segment->roles[ROLE_READER], 0.50),
+            bucket_percentile(&segment->roles[ROLE_READER], 0.99),
+            rate[ROLE_WRITER], active[ROLE_WRITER], waiting[ROLE_WRITER],
+            bucket_percentile(&segment->roles[ROLE_WRITER], 0.50),
+            bucket_percentile(&segment->roles[ROLE_WRITER], 0.99));
+        if (stalled_sec[ROLE_READER] >= STARVATION_SEC) {
+            printf("  readers starving (%ds)", stalled_sec[ROLE_READER]);
+        }
+        if (stalled_sec[ROLE_WRITER] >= STARVATION_SEC) {
+            printf("  writers starving (%ds)", stalled_sec[ROLE_WRITER]);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    if (finished) {
+        printf("Run finished: %ld reads, %ld writes\n", last_completed[ROLE_READER], last_completed[ROLE_WRITER]);
+    }
+    munmap(segment, sizeof(le_metrics_segment_t));
+    return EXIT_SUCCESS;
+}
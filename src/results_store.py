@@ -0,0 +1,335 @@
+import argparse
+import csv
+import datetime
+import math
+import os
+import platform
+import re
+import statistics
+import subprocess
+import sys
+import uuid
+from functools import lru_cache
+
+# Append-only store of benchmark runs and statistical comparison between runs.
+#
+#   python3 results_store.py record output/summary_metrics_*.csv
+#   python3 results_store.py list
+#   python3 results_store.py compare [--baseline RUN|COMMIT|previous] [--candidate RUN|COMMIT|latest] [--any-machine]
+#
+# Every recorded row keeps the machine and commit it was measured on. compare runs a one-sided
+# Mann-Whitney U test per implementation x scenario and exits with status 1 when a candidate is
+# significantly worse than the baseline by more than the effect size threshold. The baseline is taken
+# from runs on the candidate's machine (hostname, CPU model and count) unless --any-machine is given.
+# With the 3 rounds of test.sh the smallest exact p-value is 0.05; pool several runs of a commit
+# as baseline, or raise NUM_ROUNDS, for more statistical power.
+
+STORE_FILE = "output/results_store.csv"
+
+SUMMARY_COLUMNS = [
+    "implementation", "scenario", "readers", "writers", "program_exec_time_sec",
+    "reader_throughput_ops_sec", "writer_throughput_ops_sec", "total_throughput_ops_sec",
+    "perf_cpu_cycles", "perf_task_clock_ms"
+]
+
+METADATA_COLUMNS = [
+    "run_id", "recorded_at", "source_file", "hostname", "machine", "cpu_model", "cpu_count",
+    "kernel", "git_commit", "git_dirty"
+]
+
+# Columns that identify the machine a run was measured on, runs are only compared within one machine
+MACHINE_COLUMNS = ["hostname", "cpu_model", "cpu_count"]
+
+# Metrics where a larger value is better, every other metric is better when smaller
+HIGHER_IS_BETTER = {"reader_throughput_ops_sec", "writer_throughput_ops_sec", "total_throughput_ops_sec"}
+
+
+def git_output(*args):
+    try:
+        return subprocess.run(["git"] + list(args), capture_output=True, text=True, check=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def cpu_model():
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    return line.split(":", 1)[1].strip()
+    except OSError:
+        pass
+    return platform.processor()
+
+
+def git_dirty(results_dir):
+    """1 if tracked files of the repository are modified, 0 if not, 'unknown' if git cannot tell."""
+    top = git_output("rev-parse", "--show-toplevel")
+    if not top:
+        return "unknown"
+    check = ["-C", top, "status", "--porcelain", "--untracked-files=no"]
+
+    # The benchmark scripts rewrite the tracked summary CSVs next to the store, they do not make the sources dirty
+    relative = os.path.relpath(os.path.abspath(results_dir or "."), top)
+    if relative != os.pardir and not relative.startswith(os.pardir + os.sep):
+        check += ["--", ":(exclude,glob)" + ("*.csv" if relative == "." else f"{relative}/*.csv")]
+
+    status = git_output(*check)
+    if status is None:
+        return "unknown"
+    return 1 if status else 0
+
+
+def machine_metadata(results_dir):
+    return {
+        "hostname": platform.node(),
+        "machine": platform.machine(),
+        "cpu_model": cpu_model(),
+        "cpu_count": os.cpu_count(),
+        "kernel": platform.release(),
+        "git_commit": git_output("rev-parse", "HEAD") or "unknown",
+        "git_dirty": git_dirty(results_dir),
+    }
+
+
+def read_store(path):
+    if not os.path.exists(path):
+        return []
+    with open(path, newline="") as f:
+        return list(csv.DictReader(f))
+
+
+def record(args):
+    run_id = args.run_id or datetime.datetime.now().strftime("%Y%m%d-%H%M%S-") + uuid.uuid4().hex[:6]
+    metadata = machine_metadata(os.path.dirname(args.store))
+    metadata["run_id"] = run_id
+    metadata["recorded_at"] = datetime.datetime.now().isoformat(timespec="seconds")
+
+    rows = []
+    for summary in args.files:
+        with open(summary, newline="") as f:
+            for row in csv.DictReader(f):
+                entry = dict(metadata)
+                entry["source_file"] = os.path.basename(summary)
+                entry.update({column: row.get(column, "") for column in SUMMARY_COLUMNS})
+                rows.append(entry)
+
+    if not rows:
+        print("No rows found in the given summary files.", file=sys.stderr)
+        return 1
+
+    # Only ever append, the header is written when the store is created
+    new_store = not os.path.exists(args.store)
+    with open(args.store, "a", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=METADATA_COLUMNS + SUMMARY_COLUMNS)
+        if new_store:
+            writer.writeheader()
+        writer.writerows(rows)
+
+    print(f"Recorded run {run_id}: {len(rows)} rows, commit {metadata['git_commit'][:10]}"
+          f"{' (dirty)' if metadata['git_dirty'] == 1 else ' (dirty state unknown)' if metadata['git_dirty'] == 'unknown' else ''}")
+    return 0
+
+
+def runs_in_order(store):
+    runs = []
+    for row in store:
+        if row["run_id"] not in runs:
+            runs.append(row["run_id"])
+    return runs
+
+
+def list_runs(args):
+    store = read_store(args.store)
+    for run_id in runs_in_order(store):
+        rows = [row for row in store if row["run_id"] == run_id]
+        first = rows[0]
+        print(f"{run_id}  {first['recorded_at']}  {first['git_commit'][:10]}"
+              f"{ {'1': '+', 'unknown': '?'}.get(first['git_dirty'], ' ')}  {first['hostname']}  "
+              f"{first['cpu_count']} cpus  {len(rows)} rows")
+    return 0
+
+
+def run_machine(store, run):
+    row = next(row for row in store if row["run_id"] == run)
+    return tuple(row[column] for column in MACHINE_COLUMNS)
+
+
+def select_runs(store, selector, exclude=(), machine=None):
+    """Resolve a run id, a commit prefix, 'latest' or 'previous' to a list of run ids, optionally on one machine."""
+    runs = [run for run in runs_in_order(store)
+            if run not in exclude and (machine is None or run_machine(store, run) == machine)]
+    if not runs:
+        return []
+    if selector in ("latest", "previous"):
+        return [runs[-1]]
+    if selector in runs:
+        return [selector]
+    commit_runs = []
+    for run in runs:
+        commit = next(row["git_commit"] for row in store if row["run_id"] == run)
+        if commit.startswith(selector):
+            commit_runs.append(run)
+    return commit_runs
+
+
+def metric_value(row, metric):
+    # perf values may carry their unit, as in "28965815cpu-"
+    match = re.search(r"-?\d+\.?\d*", row.get(metric, "") or "")
+    return float(match.group(0)) if match else None
+
+
+@lru_cache(maxsize=None)
+def u_distribution_count(n, m, u):
+    """Number of orderings of n and m samples whose Mann-Whitney statistic equals u."""
+    if u < 0:
+        return 0
+    if n == 0 or m == 0:
+        return 1 if u == 0 else 0
+    return u_distribution_count(n - 1, m, u - m) + u_distribution_count(n, m - 1, u)
+
+
+def mann_whitney_worse(candidate, baseline):
+    """One-sided p-value for 'candidate tends to be lower than baseline' (values oriented so higher is better)."""
+    n, m = len(candidate), len(baseline)
+    u = 0.0
+    ties = False
+    for c in candidate:
+        for b in baseline:
+            if c < b:
+                u += 1
+            elif c == b:
+                u += 0.5
+                ties = True
+
+    # Exact distribution for small samples without ties, normal approximation otherwise
+    if not ties and n + m <= 30:
+        total = math.comb(n + m, n)
+        extreme = sum(u_distribution_count(n, m, k) for k in range(int(u), n * m + 1))
+        return extreme / total
+
+    values = sorted(candidate + baseline)
+    tie_term = 0
+    for value in set(values):
+        t = values.count(value)
+        tie_term += t ** 3 - t
+    mean = n * m / 2
+    variance = n * m / 12 * ((n + m + 1) - tie_term / ((n + m) * (n + m - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (u - mean - 0.5) / math.sqrt(variance)
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+def compare(args):
+    store = read_store(args.store)
+    if not store:
+        print(f"The results store {args.store} is empty.", file=sys.stderr)
+        return 2
+
+    candidate_runs = select_runs(store, args.candidate)
+    if not candidate_runs:
+        print(f"No runs match candidate '{args.candidate}'.", file=sys.stderr)
+        return 2
+    candidate_machines = {run_machine(store, run) for run in candidate_runs}
+    if len(candidate_machines) > 1:
+        print(f"Candidate '{args.candidate}' has runs from several machines, select a single run.", file=sys.stderr)
+        return 2
+    machine = candidate_machines.pop()
+
+    # Timings from another machine say nothing about a regression, the baseline comes from the same one
+    baseline_runs = select_runs(store, args.baseline, exclude=candidate_runs,
+                                machine=None if args.any_machine else machine)
+    if not baseline_runs:
+        print(f"No runs match baseline '{args.baseline}'"
+              f"{'' if args.any_machine else ' on ' + ', '.join(machine) + ' (use --any-machine to widen)'}.",
+              file=sys.stderr)
+        return 2
+    other_machines = {run_machine(store, run) for run in baseline_runs} - {machine}
+    for other in sorted(other_machines):
+        print(f"Warning: baseline includes runs from another machine ({', '.join(other)}).", file=sys.stderr)
+
+    higher_is_better = args.metric in HIGHER_IS_BETTER
+    print(f"Baseline: {', '.join(baseline_runs)}")
+    print(f"Candidate: {', '.join(candidate_runs)}")
+    print(f"Metric: {args.metric} ({'higher' if higher_is_better else 'lower'} is better), "
+          f"alpha {args.alpha}, threshold {args.threshold:.1%}\n")
+
+    def samples(runs):
+        groups = {}
+        for row in store:
+            if row["run_id"] in runs:
+                value = metric_value(row, args.metric)
+                if value is not None:
+                    groups.setdefault((row["implementation"], row["scenario"]), []).append(value)
+        return groups
+
+    baseline = samples(baseline_runs)
+    candidate = samples(candidate_runs)
+
+    regressions = 0
+    print(f"{'implementation':<28}{'scenario':<10}{'baseline':>12}{'candidate':>12}{'change':>9}{'p-value':>9}  verdict")
+    for key in sorted(set(baseline) & set(candidate)):
+        base, cand = baseline[key], candidate[key]
+        base_median, cand_median = statistics.median(base), statistics.median(cand)
+
+        # Orient everything so that a higher value is better
+        sign = 1 if higher_is_better else -1
+        if base_median == cand_median:
+            change = 0.0
+        elif base_median == 0:
+            change = math.copysign(math.inf, sign * cand_median)
+        else:
+            change = sign * (cand_median - base_median) / abs(base_median)
+        p_value = mann_whitney_worse([sign * v for v in cand], [sign * v for v in base])
+
+        if p_value <= args.alpha and change < -args.threshold:
+            verdict = "REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            verdict = "slower, not significant"
+        elif change > args.threshold:
+            verdict = "faster"
+        else:
+            verdict = "ok"
+        print(f"{key[0]:<28}{key[1]:<10}{base_median:>12.4g}{cand_median:>12.4g}{change:>+9.1%}{p_value:>9.3f}  {verdict}")
+
+    for key in sorted(set(baseline) ^ set(candidate)):
+        print(f"{key[0]:<28}{key[1]:<10}  only in {'baseline' if key in baseline else 'candidate'}")
+
+    print(f"\n{regressions} regression(s) found.")
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Store benchmark runs and compare them against a baseline.")
+    parser.add_argument("--store", default=STORE_FILE, help=f"results store (default {STORE_FILE})")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    record_parser = commands.add_parser("record", help="append summary CSV files to the store as one run")
+    record_parser.add_argument("files", nargs="+", help="summary_metrics CSV files of the run")
+    record_parser.add_argument("--run-id", help="identifier of the run (default: timestamp)")
+
+    commands.add_parser("list", help="list the stored runs")
+
+    compare_parser = commands.add_parser("compare", help="test a run against a baseline")
+    compare_parser.add_argument("--baseline", default="previous",
+                                help="run id, commit prefix (all its runs are pooled) or 'previous' (default)")
+    compare_parser.add_argument("--candidate", default="latest", help="run id, commit prefix or 'latest' (default)")
+    compare_parser.add_argument("--metric", default="total_throughput_ops_sec", choices=SUMMARY_COLUMNS[4:])
+    compare_parser.add_argument("--alpha", type=float, default=0.05, help="significance level (default 0.05)")
+    compare_parser.add_argument("--threshold", type=float, default=0.05,
+                                help="minimum relative change of the median to count as a regression (default 0.05)")
+    compare_parser.add_argument("--any-machine", action="store_true",
+                                help="also take baseline runs from other machines (default: only the candidate's)")
+
+    args = parser.parse_args()
+    if args.command == "record":
+        return record(args)
+    if args.command == "list":
+        return list_runs(args)
+    return compare(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,82 @@
+#!/bin/bash
+
+# Open loop sweep: run every implementation at increasing offered loads to find its saturation point
+OUTPUT_DIR="output"
+SWEEP_FILE="$OUTPUT_DIR/sweep_metrics.csv"
+
+EXECUTABLES=(
+    "le_semaphore"        # Writer priority with semaphores
+    "le_busy_wait"        # No priority, busy waiting
+    "le_mutex_cond"       # Reader priority with mutex and condition variables
+    "le_flat_combining"   # Reader priority, writers batched by a combiner
+    "le_cohort"           # Writer priority, write lock kept within a socket or cache domain
+)
+
+# Total offered loads (ops/sec) to try, in increasing order
+OFFERED_LOADS=(0.25 0.5 1 2 4 8)
+
+# Fraction of the offered load that are reads, the rest are writes
+READ_FRACTION=${READ_FRACTION:-0.5}
+
+# Length of the arrival window of every run, and arrival model (poisson or bursty)
+DURATION_SEC=${DURATION_SEC:-30}
+ARRIVAL_MODEL=${ARRIVAL_MODEL:-poisson}
+
+# A load is considered saturated once the p99 latency of any role goes above this bound,
+# or once any arrival is dropped (the dropped requests are not in the latency percentiles)
+P99_SLO_SEC=${P99_SLO_SEC:-6}
+
+# Environment setup
+# Check if OUTPUT_DIR exists, create if not.
+if [ ! -d "$OUTPUT_DIR" ]; then
+    mkdir -p "$OUTPUT_DIR"
+fi
+
+echo "implementation,arrival_model,offered_load_ops_sec,read_rate,write_rate,total_throughput_ops_sec,reader_p99_latency_sec,writer_p99_latency_sec,dropped_arrivals,saturated" > "$SWEEP_FILE"
+
+# Function to run one open loop point
+# run_sweep_point(executable name, offered load)
+run_sweep_point() {
+    local exec_name="$1"
+    local load="$2"
+
+    local read_rate=$(awk -v l="$load" -v f="$READ_FRACTION" 'BEGIN { printf "%.4f", l * f }')
+    local write_rate=$(awk -v l="$load" -v f="$READ_FRACTION" 'BEGIN { printf "%.4f", l * (1 - f) }')
+
+    echo "    Offered load: $load ops/sec (reads $read_rate, writes $write_rate)"
+
+    PROGRAM_FULL_OUTPUT=$("../bin/$exec_name" --open-loop "$read_rate" "$write_rate" "$DURATION_SEC" "$ARRIVAL_MODEL" 2>&1)
+
+    total_throughput=$(echo "$PROGRAM_FULL_OUTPUT" | grep "Total Throughput:" | awk '{print $3}')
+    reader_p99=$(echo "$PROGRAM_FULL_OUTPUT" | grep "Readers Latency p99:" | awk '{print $4}')
+    writer_p99=$(echo "$PROGRAM_FULL_OUTPUT" | grep "Writers Latency p99:" | awk '{print $4}')
+    dropped=$(echo "$PROGRAM_FULL_OUTPUT" | grep "Dropped Arrivals:" | awk '{print $3}')
+    dropped=${dropped:-0}
+
+    saturated=$(awk -v r="${reader_p99:-0}" -v w="${writer_p99:-0}" -v d="$dropped" -v slo="$P99_SLO_SEC" \
+                'BEGIN { print (r > slo || w > slo || d > 0) ? 1 : 0 }')
+
+    echo "$exec_name,$ARRIVAL_MODEL,$load,$read_rate,$write_rate,$total_throughput,$reader_p99,$writer_p99,$dropped,$saturated" >> "$SWEEP_FILE"
+}
+
+for exec_name in "${EXECUTABLES[@]}"; do
+    echo "--- Sweeping offered load for: $exec_name ---"
+
+    saturation_point=""
+    for load in "${OFFERED_LOADS[@]}"; do
+        run_sweep_point "$exec_name" "$load"
+
+        if [ "$(tail -n 1 "$SWEEP_FILE" | awk -F',' '{print $10}')" = "1" ]; then
+            saturation_point="$load"
+            break
+        fi
+    done
+
+    if [ -n "$saturation_point" ]; then
+        echo "    $exec_name saturates at $saturation_point ops/sec (p99 > ${P99_SLO_SEC}s or dropped arrivals)"
+    else
+        echo "    $exec_name did not saturate up to ${OFFERED_LOADS[-1]} ops/sec"
+    fi
+done
+
+echo "All sweep metrics are saved in: $SWEEP_FILE"
@@ -7,6 +7,21 @@ EXECUTABLES=(
     "le_semaphore"        # Writer priority with barrier synchronization
     "le_busy_wait"        # No priority, busy waiting
     "le_mutex_cond"       # Reader priority with mutex and condition variables
+    "le_flat_combining"   # Reader priority, writers batched by a combiner
+    "le_cohort"           # Writer priority, write lock kept within a socket or cache domain
+)
+
+# Set COMPARE_LAYOUTS=1 to also run the packed layout builds (`make packed`) and measure false sharing
+if [ "${COMPARE_LAYOUTS:-0}" = "1" ]; then
+    EXECUTABLES+=("le_semaphore_packed" "le_busy_wait_packed" "le_mutex_cond_packed" "le_flat_combining_packed" "le_cohort_packed")
+fi
+
+# sudo drops the environment, these are the variables the programs read and must keep
+PRESERVED_ENV=(
+    "LE_FAKE_NODES"       # le_cohort: fake number of nodes instead of the real topology
+    "LE_COHORT_DOMAIN"    # le_cohort: cache (default) or socket domains
+    "LE_MAX_ACTIVE"       # Admission control, see le_admission.h
+    "LE_METRICS_SHM"      # Live metrics segment for le_top, see le_metrics.h
 )
 
 # Environment setup
@@ -29,7 +44,9 @@ run_test_case() {
     echo "    Scenario: $scenario_name, R=$r, W=$w"
     
     # Execute the program with the specified number of readers and writers using perf stat
-    PROGRAM_FULL_OUTPUT=$(sudo perf stat -e 'cpu-cycles,task-clock' \
+    # The variables in PRESERVED_ENV are passed through sudo
+    PROGRAM_FULL_OUTPUT=$(sudo --preserve-env="$(IFS=,; echo "${PRESERVED_ENV[*]}")" \
+                            perf stat -e 'cpu-cycles,task-clock' \
                             "../bin/$exec_name" "$r" "$w" 2>&1)
 
 
@@ -44,8 +61,14 @@ run_test_case() {
     perf_task_clock_ms=$(echo "$PROGRAM_FULL_OUTPUT" | grep "task-clock" | awk -F'msec' '{print $1}' | tr -d ' ' | tr -d ',' | tail -n 1)
 
 
+    # Runs with admission control are labeled apart from the plain ones
+    local impl_name="$exec_name"
+    if [ -n "$LE_MAX_ACTIVE" ]; then
+        impl_name="${exec_name}+admission_${LE_MAX_ACTIVE}"
+    fi
+
     # Save the results in the csv summary file
-    echo "$exec_name,$scenario_name,$r,$w,$program_exec_time,$reader_throughput,$writer_throughput,$total_throughput,$perf_cpu_cycles,$perf_task_clock_ms" >> "$SUMMARY_FILE"
+    echo "$impl_name,$scenario_name,$r,$w,$program_exec_time,$reader_throughput,$writer_throughput,$total_throughput,$perf_cpu_cycles,$perf_task_clock_ms" >> "$SUMMARY_FILE"
 }
 
 # Number of rounds for testing
@@ -75,4 +98,12 @@ for round in $(seq 1 $NUM_ROUNDS); do
     done
 done
 
-echo "All metrics are saved in: $OUTPUT_DIR/summary_metrics_1.csv, $OUTPUT_DIR/summary_metrics_2.csv, $OUTPUT_DIR/summary_metrics_3.csv"
\ No newline at end of file
+echo "All metrics are saved in: $OUTPUT_DIR/summary_metrics_1.csv, $OUTPUT_DIR/summary_metrics_2.csv, $OUTPUT_DIR/summary_metrics_3.csv"
+
+# Append this run to the results store with machine and commit metadata
+# Compare it against the previous run with: python3 results_store.py compare
+ROUND_FILES=()
+for round in $(seq 1 $NUM_ROUNDS); do
+    ROUND_FILES+=("$OUTPUT_DIR/summary_metrics_${round}.csv")
+done
+python3 results_store.py record "${ROUND_FILES[@]}"